@@ -266,16 +266,21 @@ aes_init (uint8_t * key, uint8_t keysize, uint8_t * ta)
 }
 
 /***************************************************
- generic  call
+ context - expand key and calculate SBOX once, then run more blocks
 */
 void __attribute__ ((weak))
-aes_run (uint8_t * buf, uint8_t * key, uint8_t keysize, uint8_t mode)
+aes_ctx_init (aes_ctx_t * ctx, uint8_t * key, uint8_t keysize)
+{
+  ctx->rounds = aes_init (key, keysize, ctx->ta);
+}
+
+void __attribute__ ((weak))
+aes_ctx_run (aes_ctx_t * ctx, uint8_t * buf, uint8_t mode)
 {
-  uint8_t ta[2400];
-  uint8_t rounds;
+  uint8_t *ta = ctx->ta;
+  uint8_t rounds = ctx->rounds;
   uint8_t *kkey = KEY;
 
-  rounds = aes_init (key, keysize, ta);
   if (mode)
     {
       // decrypt
@@ -318,3 +323,16 @@ aes_run (uint8_t * buf, uint8_t * key, uint8_t keysize, uint8_t mode)
       addEKey (buf, kkey);
     }
 }
+
+/***************************************************
+ generic  call
+*/
+void __attribute__ ((weak))
+aes_run (uint8_t * buf, uint8_t * key, uint8_t keysize, uint8_t mode)
+{
+  aes_ctx_t ctx;
+
+  aes_ctx_init (&ctx, key, keysize);
+  aes_ctx_run (&ctx, buf, mode);
+  memset (&ctx, 0, sizeof (ctx));
+}
@@ -26,3 +26,31 @@ expanded in RAM, SBOX and INV SBOX is calculated in RAM.
 */
 
 void aes_run (uint8_t * data, uint8_t * key, uint8_t keysize, uint8_t mode);
+
+// expanded key, SBOX and INV SBOX, reusable for more blocks
+typedef struct
+{
+#ifdef AES_NI
+  // holds hardware round keys too (aes_ctx_hw_init)
+  uint8_t ta[3 * 256] __attribute__ ((aligned (16)));
+#else
+  uint8_t ta[3 * 256];
+#endif
+  uint8_t rounds;
+} aes_ctx_t;
+
+void aes_ctx_init (aes_ctx_t * ctx, uint8_t * key, uint8_t keysize);
+void aes_ctx_run (aes_ctx_t * ctx, uint8_t * data, uint8_t mode);
+
+#ifdef AES_NI
+// target specific hardware AES, CBC (or ECB if iv == NULL) in place, iv is
+// updated for next operation, return 0 if hardware is not available
+uint8_t aes_cbc_hw (uint8_t * data, uint16_t len, uint8_t * key,
+		    uint8_t keysize, uint8_t * iv, uint8_t mode);
+// expand key for hardware AES into ctx (reusable for more calls of
+// aes_cbc_hw_ctx), return 0 if hardware is not available
+uint8_t aes_ctx_hw_init (aes_ctx_t * ctx, uint8_t * key, uint8_t keysize);
+// same as aes_cbc_hw(), key is already expanded by aes_ctx_hw_init()
+void aes_cbc_hw_ctx (aes_ctx_t * ctx, uint8_t * data, uint16_t len,
+		     uint8_t * iv, uint8_t mode);
+#endif
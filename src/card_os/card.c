@@ -29,6 +29,9 @@
 #include "iso7816.h"
 #include "myeid_emu.h"
 #include "fs.h"
+#ifdef ECDSA_PRECOMPUTE
+#include "ec.h"
+#endif
 
 #ifdef CARD_RESTART
 #include "restart.h"
@@ -44,6 +47,10 @@ int main(void)
 	fs_init();
 	//initialize random number generator
 	rnd_init();
+#ifdef ECDSA_PRECOMPUTE
+	// drop precomputed ECDSA nonces
+	ecdsa_precompute_clear();
+#endif
 	//initialize myeid emulation (not valid security env)
 	security_env_set_reset(NULL, NULL);
 	// initialize iso part of card
@@ -0,0 +1,265 @@
+/*
+    chacha20.c
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    ChaCha20-Poly1305 AEAD (RFC 8439)
+
+    ChaCha20 uses only 32 bit add/rotate/xor, Poly1305 is calculated with 8
+    bit limbs (17 x uint32_t), no tables, no data dependent branches.  Code
+    is designed for small size, not for speed.
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "chacha20.h"
+
+#define ROL(x,n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint32_t
+load32_le (uint8_t * p)
+{
+  return p[0] | (uint32_t) p[1] << 8 | (uint32_t) p[2] << 16 |
+    (uint32_t) p[3] << 24;
+}
+
+static void
+store32_le (uint8_t * p, uint32_t v)
+{
+  uint8_t i;
+
+  for (i = 0; i < 4; i++)
+    {
+      p[i] = v;
+      v >>= 8;
+    }
+}
+
+// one 64 bytes block of key stream
+static void
+chacha20_block (uint8_t * out, uint8_t * key, uint8_t * nonce,
+		uint32_t counter)
+{
+  // quarter round indexes: 4 columns, 4 diagonals
+  static const uint8_t qr[8][4] = {
+    {0, 4, 8, 12}, {1, 5, 9, 13}, {2, 6, 10, 14}, {3, 7, 11, 15},
+    {0, 5, 10, 15}, {1, 6, 11, 12}, {2, 7, 8, 13}, {3, 4, 9, 14}
+  };
+  uint32_t s[16], x[16];
+  uint32_t *a, *b, *c, *d;
+  uint8_t i, j;
+
+  s[0] = 0x61707865;
+  s[1] = 0x3320646e;
+  s[2] = 0x79622d32;
+  s[3] = 0x6b206574;
+  for (i = 0; i < 8; i++)
+    s[4 + i] = load32_le (key + 4 * i);
+  s[12] = counter;
+  for (i = 0; i < 3; i++)
+    s[13 + i] = load32_le (nonce + 4 * i);
+
+  memcpy (x, s, sizeof (x));
+  for (i = 0; i < 10; i++)
+    for (j = 0; j < 8; j++)
+      {
+	a = x + qr[j][0];
+	b = x + qr[j][1];
+	c = x + qr[j][2];
+	d = x + qr[j][3];
+	*a += *b;
+	*d ^= *a;
+	*d = ROL (*d, 16);
+	*c += *d;
+	*b ^= *c;
+	*b = ROL (*b, 12);
+	*a += *b;
+	*d ^= *a;
+	*d = ROL (*d, 8);
+	*c += *d;
+	*b ^= *c;
+	*b = ROL (*b, 7);
+      }
+  for (i = 0; i < 16; i++)
+    store32_le (out + 4 * i, x[i] + s[i]);
+  memset (x, 0, sizeof (x));
+  memset (s, 0, sizeof (s));
+}
+
+static void
+chacha20_xor (uint8_t * data, uint16_t len, uint8_t * key, uint8_t * nonce)
+{
+  uint8_t ks[64];
+  uint32_t counter = 1;
+  uint8_t i;
+
+  while (len)
+    {
+      chacha20_block (ks, key, nonce, counter++);
+      for (i = 0; i < 64 && len; i++, len--)
+	*data++ ^= ks[i];
+    }
+  memset (ks, 0, sizeof (ks));
+}
+
+// Poly1305, h, r in 8 bit limbs
+typedef struct
+{
+  uint32_t h[17];
+  uint32_t r[17];
+} poly1305_ctx_t;
+
+static void
+poly1305_add (uint32_t * h, const uint32_t * c)
+{
+  uint32_t u = 0;
+  uint8_t j;
+
+  for (j = 0; j < 17; j++)
+    {
+      u += h[j] + c[j];
+      h[j] = u & 255;
+      u >>= 8;
+    }
+}
+
+// one 16 bytes block (data is zero padded to full block, RFC 8439 2.8)
+static void
+poly1305_block (poly1305_ctx_t * ctx, uint8_t * m, uint8_t n)
+{
+  uint32_t c[17], x[17];
+  uint32_t u;
+  uint8_t i, j;
+
+  memset (c, 0, sizeof (c));
+  for (j = 0; j < n; j++)
+    c[j] = m[j];
+  c[16] = 1;
+  poly1305_add (ctx->h, c);
+
+  // h = h * r mod 2^130 - 5 (2^136 = 320 mod p in 8 bit limbs)
+  for (i = 0; i < 17; i++)
+    {
+      x[i] = 0;
+      for (j = 0; j < 17; j++)
+	x[i] += ctx->h[j] * ((j <= i) ? ctx->r[i - j] :
+			     320 * ctx->r[i + 17 - j]);
+    }
+  u = 0;
+  for (j = 0; j < 16; j++)
+    {
+      u += x[j];
+      ctx->h[j] = u & 255;
+      u >>= 8;
+    }
+  u += x[16];
+  ctx->h[16] = u & 3;
+  u = 5 * (u >> 2);
+  for (j = 0; j < 16; j++)
+    {
+      u += ctx->h[j];
+      ctx->h[j] = u & 255;
+      u >>= 8;
+    }
+  ctx->h[16] += u;
+}
+
+static void
+poly1305_data (poly1305_ctx_t * ctx, uint8_t * m, uint16_t len)
+{
+  while (len)
+    {
+      uint8_t n = len > 16 ? 16 : len;
+
+      poly1305_block (ctx, m, n);
+      m += n;
+      len -= n;
+    }
+}
+
+// tag of ciphertext (no additional data), key = one time key (32 bytes)
+static void
+poly1305_tag (uint8_t * tag, uint8_t * data, uint16_t len, uint8_t * key)
+{
+  static const uint32_t minusp[17] = {
+    5, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 252
+  };
+  poly1305_ctx_t ctx;
+  uint32_t g[17], s;
+  uint8_t lengths[16];
+  uint8_t j;
+
+  memset (&ctx, 0, sizeof (ctx));
+  for (j = 0; j < 16; j++)
+    ctx.r[j] = key[j];
+  ctx.r[3] &= 15;
+  ctx.r[4] &= 252;
+  ctx.r[7] &= 15;
+  ctx.r[8] &= 252;
+  ctx.r[11] &= 15;
+  ctx.r[12] &= 252;
+  ctx.r[15] &= 15;
+
+  poly1305_data (&ctx, data, len);
+  // 64 bit length of AAD (0) and ciphertext
+  memset (lengths, 0, sizeof (lengths));
+  lengths[8] = len;
+  lengths[9] = len >> 8;
+  poly1305_block (&ctx, lengths, 16);
+
+  // final reduction, constant time select of h or h - p
+  memcpy (g, ctx.h, sizeof (g));
+  poly1305_add (ctx.h, minusp);
+  s = -(ctx.h[16] >> 7);
+  for (j = 0; j < 17; j++)
+    ctx.h[j] ^= s & (g[j] ^ ctx.h[j]);
+  for (j = 0; j < 16; j++)
+    g[j] = key[j + 16];
+  g[16] = 0;
+  poly1305_add (ctx.h, g);
+  for (j = 0; j < 16; j++)
+    tag[j] = ctx.h[j];
+  memset (&ctx, 0, sizeof (ctx));
+}
+
+uint8_t
+chacha20_poly1305 (uint8_t * data, uint16_t len, uint8_t * key,
+		   uint8_t * nonce, uint8_t * tag, uint8_t mode)
+{
+  uint8_t otk[64];
+  uint8_t t[POLY1305_TAG_LEN];
+  uint8_t j, diff = 0;
+
+  // one time Poly1305 key from block 0
+  chacha20_block (otk, key, nonce, 0);
+  if (mode == 0)
+    {
+      chacha20_xor (data, len, key, nonce);
+      poly1305_tag (tag, data, len, otk);
+    }
+  else
+    {
+      poly1305_tag (t, data, len, otk);
+      for (j = 0; j < POLY1305_TAG_LEN; j++)
+	diff |= t[j] ^ tag[j];
+      if (!diff)
+	chacha20_xor (data, len, key, nonce);
+    }
+  memset (otk, 0, sizeof (otk));
+  return diff != 0;
+}
@@ -0,0 +1,36 @@
+/*
+    chacha20.h
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    ChaCha20-Poly1305 AEAD (RFC 8439) header file
+
+*/
+#ifndef _CHACHA20_H_
+#define _CHACHA20_H_
+
+#define CHACHA20_KEY_LEN 32
+#define CHACHA20_NONCE_LEN 12
+#define POLY1305_TAG_LEN 16
+
+// AEAD without additional data, data is encrypted/decrypted in place
+// mode 0: encrypt, tag is written to 'tag'
+// mode 1: decrypt, tag is checked before decryption, return 1 if tag is wrong
+uint8_t chacha20_poly1305 (uint8_t * data, uint16_t len, uint8_t * key,
+			   uint8_t * nonce, uint8_t * tag, uint8_t mode);
+#endif
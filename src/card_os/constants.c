@@ -24,6 +24,7 @@
 #ifndef HAVE_GET_CONSTANTS
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include "constants.h"
 
 /* *INDENT-OFF* */
@@ -34,39 +35,40 @@ uint8_t constants[] = {
 };
 /* *INDENT-ON* */
 
+// constant ID -> offset of constant size in constants[] (0 = unknown ID),
+// filled by one pass over constants[] on first call of get_constant()
+static uint16_t constant_index[128];
+static uint8_t constant_indexed;
+
+static void
+index_constants (void)
+{
+  uint16_t i = 0;
+
+  while (constants[i] != 0xff)
+    {
+      if (!constant_index[constants[i] & 0x7f])
+	constant_index[constants[i] & 0x7f] = i + 1;
+      i += constants[i + 1] + 2;
+    }
+  constant_indexed = 1;
+}
+
 uint8_t
 get_constant (void *here, uint8_t id)
 {
-  uint8_t *t;
-  uint8_t *s = constants;
-  uint8_t size;
+  uint16_t i;
+
+  if (!constant_indexed)
+    index_constants ();
 
-  t = (uint8_t *) here;
-  for (;;)
+  i = constant_index[id & 0x7f];
+  if (!i || constants[i - 1] != id)
     {
-      if (*s == 0xff)
-	{
-	  fprintf (stderr, "Unknown constant %d\n", id);
-	  return 0;
-	}
-      if (*s == id)
-	{
-	  s++;
-	  size = *s;
-	  s++;
-	  while (size)
-	    {
-	      *t = *s;
-	      t++;
-	      s++;
-	      size--;
-	    }
-	  return 1;
-	}
-      s++;
-      size = *s;
-      s++;
-      s += size;
+      fprintf (stderr, "Unknown constant %d\n", id);
+      return 0;
     }
+  memcpy (here, constants + i + 1, constants[i]);
+  return 1;
 }
 #endif
@@ -0,0 +1,198 @@
+/*
+    ctr_drbg.c
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    CTR_DRBG (NIST SP 800-90A rev. 1), AES-256, with derivation function
+
+    rnd_get() is served from this generator, target rnd_hw_get() is used
+    only as entropy source (instantiate and reseed).  Hardware entropy is
+    not full entropy, the derivation function (Block_Cipher_df) is used to
+    condition 48 bytes from rnd_hw_get() (entropy input and nonce) into
+    seed material.  No personalization string, no additional input, no
+    prediction resistance.  Generator is instantiated on first rnd_get()
+    call and reseeded after CTR_DRBG_RESEED requests.
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "rnd.h"
+#include "aes.h"
+
+#ifndef CTR_DRBG_RESEED
+#define CTR_DRBG_RESEED 256
+#endif
+
+// key length 32, block length 16, seedlen 48
+#define DRBG_KEYLEN 32
+#define DRBG_SEEDLEN 48
+
+static struct
+{
+  uint8_t key[DRBG_KEYLEN];
+  uint8_t v[16];
+  // 0 = not instantiated
+  uint16_t reseed_counter;
+} drbg;
+
+// ECB encrypt "len" bytes in place (len is multiple of 16)
+static void
+drbg_ecb (uint8_t * data, uint16_t len, uint8_t * key)
+{
+#ifdef AES_NI
+  if (aes_cbc_hw (data, len, key, DRBG_KEYLEN, NULL, 0))
+    return;
+#endif
+  for (; len; len -= 16, data += 16)
+    aes_run (data, key, DRBG_KEYLEN, 0);
+}
+
+// fill "len" bytes with V+1, V+2 .. and update V (len is multiple of 16)
+static void
+drbg_counters (uint8_t * data, uint16_t len)
+{
+  int8_t i;
+
+  for (; len; len -= 16, data += 16)
+    {
+      for (i = 15; i >= 0; i--)
+	if (++drbg.v[i])
+	  break;
+      memcpy (data, drbg.v, 16);
+    }
+}
+
+// CTR_DRBG_Update (10.2.1.2)
+static void
+drbg_update (uint8_t * provided_data)
+{
+  uint8_t temp[DRBG_SEEDLEN];
+  uint8_t i;
+
+  drbg_counters (temp, DRBG_SEEDLEN);
+  drbg_ecb (temp, DRBG_SEEDLEN, drbg.key);
+  if (provided_data)
+    for (i = 0; i < DRBG_SEEDLEN; i++)
+      temp[i] ^= provided_data[i];
+  memcpy (drbg.key, temp, DRBG_KEYLEN);
+  memcpy (drbg.v, temp + DRBG_KEYLEN, 16);
+  memset (temp, 0, DRBG_SEEDLEN);
+}
+
+/*
+Block_Cipher_df (10.3.2), input string is fixed (48 bytes), output 48 bytes
+
+S = L || N || input_string || 0x80 || padding = 4 blocks, BCC is calculated
+over IV || S (IV = 32 bit counter || zeros), 3 BCC outputs are used as new
+key and X, then X is encrypted 3 times to get the seed material.
+*/
+static void
+drbg_df (uint8_t * seed)
+{
+  uint8_t s[16 + 64];
+  uint8_t k[DRBG_KEYLEN];
+  uint8_t temp[DRBG_SEEDLEN];
+  uint8_t *x;
+  uint8_t i, j, b;
+
+  memset (s, 0, sizeof (s));
+  // L = 48, N = 48 (32 bit big endian values)
+  s[16 + 3] = DRBG_SEEDLEN;
+  s[16 + 7] = DRBG_SEEDLEN;
+  memcpy (s + 16 + 8, seed, DRBG_SEEDLEN);
+  s[16 + 8 + DRBG_SEEDLEN] = 0x80;
+
+  for (i = 0; i < DRBG_KEYLEN; i++)
+    k[i] = i;
+
+  for (j = 0; j < DRBG_SEEDLEN / 16; j++)
+    {
+      // IV = j || 0^96
+      s[3] = j;
+      // BCC (CBC-MAC)
+      x = temp + j * 16;
+      memset (x, 0, 16);
+      for (b = 0; b < sizeof (s); b += 16)
+	{
+	  for (i = 0; i < 16; i++)
+	    x[i] ^= s[b + i];
+	  drbg_ecb (x, 16, k);
+	}
+    }
+  memcpy (k, temp, DRBG_KEYLEN);
+  x = temp + DRBG_KEYLEN;
+  for (j = 0; j < DRBG_SEEDLEN; j += 16)
+    {
+      drbg_ecb (x, 16, k);
+      memcpy (seed + j, x, 16);
+    }
+  memset (s, 0, sizeof (s));
+  memset (k, 0, sizeof (k));
+  memset (temp, 0, sizeof (temp));
+}
+
+// instantiate (10.2.1.3.2) or reseed (10.2.1.4.2)
+static void
+drbg_seed (void)
+{
+  uint8_t seed[DRBG_SEEDLEN];
+
+  // instantiate: entropy input (32 bytes) and nonce (16 bytes)
+  // reseed: entropy input (48 bytes)
+  rnd_hw_get (seed, DRBG_SEEDLEN);
+  drbg_df (seed);
+  if (drbg.reseed_counter == 0)
+    memset (&drbg, 0, sizeof (drbg));
+  drbg_update (seed);
+  drbg.reseed_counter = 1;
+  memset (seed, 0, DRBG_SEEDLEN);
+}
+
+// for size == 0 return 256 bytes
+void
+rnd_get (uint8_t * r, uint8_t size)
+{
+  uint16_t len = size;
+  uint8_t tail;
+  uint8_t block[16];
+
+  if (len == 0)
+    len = 256;
+
+  if (drbg.reseed_counter == 0 || drbg.reseed_counter > CTR_DRBG_RESEED)
+    drbg_seed ();
+
+  // generate (10.2.1.5.2), full blocks directly in output buffer
+  tail = len & 15;
+  len &= ~15;
+  if (len)
+    {
+      drbg_counters (r, len);
+      drbg_ecb (r, len, drbg.key);
+    }
+  if (tail)
+    {
+      drbg_counters (block, 16);
+      drbg_ecb (block, 16, drbg.key);
+      memcpy (r + len, block, tail);
+      memset (block, 0, 16);
+    }
+  // backtracking resistance
+  drbg_update (NULL);
+  drbg.reseed_counter++;
+}
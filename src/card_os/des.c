@@ -41,6 +41,12 @@
     Initial and inverse initial permutation is done by procedures. Key
     expansion is in procedure too. Only permutation (P) is unchanged.
 
+    If compiled with DES_CTX (targets where FLASH is not scarce), classic
+    32 bit implementation is used: key schedule is calculated once
+    (des_ctx_init()) and reused for more blocks, S-boxes and permutation P
+    are merged into eight SP tables (2kB), initial and final permutation is
+    done by bit swaps.
+
 */
 #include <string.h>
 #include <stdint.h>
@@ -76,6 +82,303 @@
 #endif
 
 
+#ifdef DES_CTX
+/* *INDENT-OFF* */
+// S-box n merged with permutation P, result rotated left by one bit
+static const uint32_t SP1[64] = {
+  0x01010400, 0x00000000, 0x00010000, 0x01010404, 0x01010004, 0x00010404,
+  0x00000004, 0x00010000, 0x00000400, 0x01010400, 0x01010404, 0x00000400,
+  0x01000404, 0x01010004, 0x01000000, 0x00000004, 0x00000404, 0x01000400,
+  0x01000400, 0x00010400, 0x00010400, 0x01010000, 0x01010000, 0x01000404,
+  0x00010004, 0x01000004, 0x01000004, 0x00010004, 0x00000000, 0x00000404,
+  0x00010404, 0x01000000, 0x00010000, 0x01010404, 0x00000004, 0x01010000,
+  0x01010400, 0x01000000, 0x01000000, 0x00000400, 0x01010004, 0x00010000,
+  0x00010400, 0x01000004, 0x00000400, 0x00000004, 0x01000404, 0x00010404,
+  0x01010404, 0x00010004, 0x01010000, 0x01000404, 0x01000004, 0x00000404,
+  0x00010404, 0x01010400, 0x00000404, 0x01000400, 0x01000400, 0x00000000,
+  0x00010004, 0x00010400, 0x00000000, 0x01010004
+};
+
+static const uint32_t SP2[64] = {
+  0x80108020, 0x80008000, 0x00008000, 0x00108020, 0x00100000, 0x00000020,
+  0x80100020, 0x80008020, 0x80000020, 0x80108020, 0x80108000, 0x80000000,
+  0x80008000, 0x00100000, 0x00000020, 0x80100020, 0x00108000, 0x00100020,
+  0x80008020, 0x00000000, 0x80000000, 0x00008000, 0x00108020, 0x80100000,
+  0x00100020, 0x80000020, 0x00000000, 0x00108000, 0x00008020, 0x80108000,
+  0x80100000, 0x00008020, 0x00000000, 0x00108020, 0x80100020, 0x00100000,
+  0x80008020, 0x80100000, 0x80108000, 0x00008000, 0x80100000, 0x80008000,
+  0x00000020, 0x80108020, 0x00108020, 0x00000020, 0x00008000, 0x80000000,
+  0x00008020, 0x80108000, 0x00100000, 0x80000020, 0x00100020, 0x80008020,
+  0x80000020, 0x00100020, 0x00108000, 0x00000000, 0x80008000, 0x00008020,
+  0x80000000, 0x80100020, 0x80108020, 0x00108000
+};
+
+static const uint32_t SP3[64] = {
+  0x00000208, 0x08020200, 0x00000000, 0x08020008, 0x08000200, 0x00000000,
+  0x00020208, 0x08000200, 0x00020008, 0x08000008, 0x08000008, 0x00020000,
+  0x08020208, 0x00020008, 0x08020000, 0x00000208, 0x08000000, 0x00000008,
+  0x08020200, 0x00000200, 0x00020200, 0x08020000, 0x08020008, 0x00020208,
+  0x08000208, 0x00020200, 0x00020000, 0x08000208, 0x00000008, 0x08020208,
+  0x00000200, 0x08000000, 0x08020200, 0x08000000, 0x00020008, 0x00000208,
+  0x00020000, 0x08020200, 0x08000200, 0x00000000, 0x00000200, 0x00020008,
+  0x08020208, 0x08000200, 0x08000008, 0x00000200, 0x00000000, 0x08020008,
+  0x08000208, 0x00020000, 0x08000000, 0x08020208, 0x00000008, 0x00020208,
+  0x00020200, 0x08000008, 0x08020000, 0x08000208, 0x00000208, 0x08020000,
+  0x00020208, 0x00000008, 0x08020008, 0x00020200
+};
+
+static const uint32_t SP4[64] = {
+  0x00802001, 0x00002081, 0x00002081, 0x00000080, 0x00802080, 0x00800081,
+  0x00800001, 0x00002001, 0x00000000, 0x00802000, 0x00802000, 0x00802081,
+  0x00000081, 0x00000000, 0x00800080, 0x00800001, 0x00000001, 0x00002000,
+  0x00800000, 0x00802001, 0x00000080, 0x00800000, 0x00002001, 0x00002080,
+  0x00800081, 0x00000001, 0x00002080, 0x00800080, 0x00002000, 0x00802080,
+  0x00802081, 0x00000081, 0x00800080, 0x00800001, 0x00802000, 0x00802081,
+  0x00000081, 0x00000000, 0x00000000, 0x00802000, 0x00002080, 0x00800080,
+  0x00800081, 0x00000001, 0x00802001, 0x00002081, 0x00002081, 0x00000080,
+  0x00802081, 0x00000081, 0x00000001, 0x00002000, 0x00800001, 0x00002001,
+  0x00802080, 0x00800081, 0x00002001, 0x00002080, 0x00800000, 0x00802001,
+  0x00000080, 0x00800000, 0x00002000, 0x00802080
+};
+
+static const uint32_t SP5[64] = {
+  0x00000100, 0x02080100, 0x02080000, 0x42000100, 0x00080000, 0x00000100,
+  0x40000000, 0x02080000, 0x40080100, 0x00080000, 0x02000100, 0x40080100,
+  0x42000100, 0x42080000, 0x00080100, 0x40000000, 0x02000000, 0x40080000,
+  0x40080000, 0x00000000, 0x40000100, 0x42080100, 0x42080100, 0x02000100,
+  0x42080000, 0x40000100, 0x00000000, 0x42000000, 0x02080100, 0x02000000,
+  0x42000000, 0x00080100, 0x00080000, 0x42000100, 0x00000100, 0x02000000,
+  0x40000000, 0x02080000, 0x42000100, 0x40080100, 0x02000100, 0x40000000,
+  0x42080000, 0x02080100, 0x40080100, 0x00000100, 0x02000000, 0x42080000,
+  0x42080100, 0x00080100, 0x42000000, 0x42080100, 0x02080000, 0x00000000,
+  0x40080000, 0x42000000, 0x00080100, 0x02000100, 0x40000100, 0x00080000,
+  0x00000000, 0x40080000, 0x02080100, 0x40000100
+};
+
+static const uint32_t SP6[64] = {
+  0x20000010, 0x20400000, 0x00004000, 0x20404010, 0x20400000, 0x00000010,
+  0x20404010, 0x00400000, 0x20004000, 0x00404010, 0x00400000, 0x20000010,
+  0x00400010, 0x20004000, 0x20000000, 0x00004010, 0x00000000, 0x00400010,
+  0x20004010, 0x00004000, 0x00404000, 0x20004010, 0x00000010, 0x20400010,
+  0x20400010, 0x00000000, 0x00404010, 0x20404000, 0x00004010, 0x00404000,
+  0x20404000, 0x20000000, 0x20004000, 0x00000010, 0x20400010, 0x00404000,
+  0x20404010, 0x00400000, 0x00004010, 0x20000010, 0x00400000, 0x20004000,
+  0x20000000, 0x00004010, 0x20000010, 0x20404010, 0x00404000, 0x20400000,
+  0x00404010, 0x20404000, 0x00000000, 0x20400010, 0x00000010, 0x00004000,
+  0x20400000, 0x00404010, 0x00004000, 0x00400010, 0x20004010, 0x00000000,
+  0x20404000, 0x20000000, 0x00400010, 0x20004010
+};
+
+static const uint32_t SP7[64] = {
+  0x00200000, 0x04200002, 0x04000802, 0x00000000, 0x00000800, 0x04000802,
+  0x00200802, 0x04200800, 0x04200802, 0x00200000, 0x00000000, 0x04000002,
+  0x00000002, 0x04000000, 0x04200002, 0x00000802, 0x04000800, 0x00200802,
+  0x00200002, 0x04000800, 0x04000002, 0x04200000, 0x04200800, 0x00200002,
+  0x04200000, 0x00000800, 0x00000802, 0x04200802, 0x00200800, 0x00000002,
+  0x04000000, 0x00200800, 0x04000000, 0x00200800, 0x00200000, 0x04000802,
+  0x04000802, 0x04200002, 0x04200002, 0x00000002, 0x00200002, 0x04000000,
+  0x04000800, 0x00200000, 0x04200800, 0x00000802, 0x00200802, 0x04200800,
+  0x00000802, 0x04000002, 0x04200802, 0x04200000, 0x00200800, 0x00000000,
+  0x00000002, 0x04200802, 0x00000000, 0x00200802, 0x04200000, 0x00000800,
+  0x04000002, 0x04000800, 0x00000800, 0x00200002
+};
+
+static const uint32_t SP8[64] = {
+  0x10001040, 0x00001000, 0x00040000, 0x10041040, 0x10000000, 0x10001040,
+  0x00000040, 0x10000000, 0x00040040, 0x10040000, 0x10041040, 0x00041000,
+  0x10041000, 0x00041040, 0x00001000, 0x00000040, 0x10040000, 0x10000040,
+  0x10001000, 0x00001040, 0x00041000, 0x00040040, 0x10040040, 0x10041000,
+  0x00001040, 0x00000000, 0x00000000, 0x10040040, 0x10000040, 0x10001000,
+  0x00041040, 0x00040000, 0x00041040, 0x00040000, 0x10041000, 0x00001000,
+  0x00000040, 0x10040040, 0x00001000, 0x00041040, 0x10001000, 0x00000040,
+  0x10000040, 0x10040000, 0x10040040, 0x10000000, 0x00040000, 0x10001040,
+  0x00000000, 0x10041040, 0x00040040, 0x10000040, 0x10040000, 0x10001000,
+  0x10001040, 0x00000000, 0x10041040, 0x00041000, 0x00041000, 0x00001040,
+  0x00001040, 0x00040040, 0x10000000, 0x10041000
+};
+
+// bit positions (1 = MSB of key[0])
+static const uint8_t PC1[56] = {
+  57, 49, 41, 33, 25, 17,  9,  1, 58, 50, 42, 34, 26, 18,
+  10,  2, 59, 51, 43, 35, 27, 19, 11,  3, 60, 52, 44, 36,
+  63, 55, 47, 39, 31, 23, 15,  7, 62, 54, 46, 38, 30, 22,
+  14,  6, 61, 53, 45, 37, 29, 21, 13,  5, 28, 20, 12,  4,
+};
+
+static const uint8_t PC2[48] = {
+  14, 17, 11, 24,  1,  5,  3, 28, 15,  6, 21, 10,
+  23, 19, 12,  4, 26,  8, 16,  7, 27, 20, 13,  2,
+  41, 52, 31, 37, 47, 55, 30, 40, 51, 45, 33, 48,
+  44, 49, 39, 56, 34, 53, 46, 42, 50, 36, 29, 32,
+};
+/* *INDENT-ON* */
+
+#define ROL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+static uint32_t
+des_load32 (uint8_t * p)
+{
+  return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 |
+    (uint32_t) p[2] << 8 | p[3];
+}
+
+static void
+des_store32 (uint8_t * p, uint32_t v)
+{
+  p[0] = v >> 24;
+  p[1] = v >> 16;
+  p[2] = v >> 8;
+  p[3] = v;
+}
+
+// 16 subkeys, each split to 8 x 6 bits, in same order as SP tables are
+// addressed in des_rounds()
+static void
+des_key_schedule (uint32_t * ks, uint8_t * key, uint8_t decrypt)
+{
+  uint32_t c = 0, d = 0;
+  uint16_t ss = 0x7efc;		// shift size 1 or 2
+  uint8_t g[8];
+  uint8_t i, j, b;
+
+  for (i = 0; i < 28; i++)
+    {
+      b = PC1[i] - 1;
+      c = (c << 1) | ((key[b >> 3] >> (7 - (b & 7))) & 1);
+      b = PC1[i + 28] - 1;
+      d = (d << 1) | ((key[b >> 3] >> (7 - (b & 7))) & 1);
+    }
+  for (i = 0; i < 16; i++, ss >>= 1)
+    {
+      for (j = 0; j <= (ss & 1); j++)
+	{
+	  c = ((c << 1) | (c >> 27)) & 0x0fffffff;
+	  d = ((d << 1) | (d >> 27)) & 0x0fffffff;
+	}
+      memset (g, 0, 8);
+      for (j = 0; j < 48; j++)
+	{
+	  b = PC2[j] - 1;
+	  b = b < 28 ? (c >> (27 - b)) & 1 : (d >> (55 - b)) & 1;
+	  g[j / 6] = (g[j / 6] << 1) | b;
+	}
+      j = 2 * (decrypt ? 15 - i : i);
+      ks[j] = (uint32_t) g[0] << 24 | (uint32_t) g[2] << 16 |
+	(uint32_t) g[4] << 8 | g[6];
+      ks[j + 1] = (uint32_t) g[1] << 24 | (uint32_t) g[3] << 16 |
+	(uint32_t) g[5] << 8 | g[7];
+    }
+  c = d = 0;
+  memset (g, 0, 8);
+}
+
+static void
+des_rounds (uint32_t * left, uint32_t * right, uint32_t * ks)
+{
+  uint32_t l = *left, r = *right, t, f;
+  uint8_t i;
+
+  for (i = 0; i < 8; i++)
+    {
+      t = ROL32 (r, 28) ^ *ks++;
+      f = SP7[t & 0x3f] | SP5[(t >> 8) & 0x3f] |
+	SP3[(t >> 16) & 0x3f] | SP1[(t >> 24) & 0x3f];
+      t = r ^ *ks++;
+      f |= SP8[t & 0x3f] | SP6[(t >> 8) & 0x3f] |
+	SP4[(t >> 16) & 0x3f] | SP2[(t >> 24) & 0x3f];
+      l ^= f;
+
+      t = ROL32 (l, 28) ^ *ks++;
+      f = SP7[t & 0x3f] | SP5[(t >> 8) & 0x3f] |
+	SP3[(t >> 16) & 0x3f] | SP1[(t >> 24) & 0x3f];
+      t = l ^ *ks++;
+      f |= SP8[t & 0x3f] | SP6[(t >> 8) & 0x3f] |
+	SP4[(t >> 16) & 0x3f] | SP2[(t >> 24) & 0x3f];
+      r ^= f;
+    }
+  // swap halves (output of last round)
+  *left = r;
+  *right = l;
+}
+
+void
+des_ctx_init (des_ctx_t * ctx, uint8_t * key, uint8_t mode)
+{
+  uint8_t i;
+
+  ctx->count = (mode & DES_3DES) ? 3 : 1;
+  // 3DES: EDE with K1,K2,K3 or DED with K3,K2,K1
+  for (i = 0; i < ctx->count; i++)
+    des_key_schedule (ctx->ks[i],
+		      key + 8 * ((ctx->count == 3 && (mode & 2)) ? 2 - i : i),
+		      ((mode >> 1) ^ i) & 1);
+}
+
+void
+des_ctx_run (des_ctx_t * ctx, uint8_t * data)
+{
+  uint32_t l, r, t;
+  uint8_t i;
+
+  l = des_load32 (data);
+  r = des_load32 (data + 4);
+
+  // initial permutation (R and L are rotated left by one bit)
+  t = ((l >> 4) ^ r) & 0x0f0f0f0f;
+  r ^= t;
+  l ^= t << 4;
+  t = ((l >> 16) ^ r) & 0x0000ffff;
+  r ^= t;
+  l ^= t << 16;
+  t = ((r >> 2) ^ l) & 0x33333333;
+  l ^= t;
+  r ^= t << 2;
+  t = ((r >> 8) ^ l) & 0x00ff00ff;
+  l ^= t;
+  r ^= t << 8;
+  r = ROL32 (r, 1);
+  t = (l ^ r) & 0xaaaaaaaa;
+  l ^= t;
+  r ^= t;
+  l = ROL32 (l, 1);
+
+  // final/initial permutation between 3DES stages cancel out
+  for (i = 0; i < ctx->count; i++)
+    des_rounds (&l, &r, ctx->ks[i]);
+
+  // final permutation
+  l = ROL32 (l, 31);
+  t = (r ^ l) & 0xaaaaaaaa;
+  r ^= t;
+  l ^= t;
+  r = ROL32 (r, 31);
+  t = ((r >> 8) ^ l) & 0x00ff00ff;
+  l ^= t;
+  r ^= t << 8;
+  t = ((r >> 2) ^ l) & 0x33333333;
+  l ^= t;
+  r ^= t << 2;
+  t = ((l >> 16) ^ r) & 0x0000ffff;
+  r ^= t;
+  l ^= t << 16;
+  t = ((l >> 4) ^ r) & 0x0f0f0f0f;
+  r ^= t;
+  l ^= t << 4;
+
+  des_store32 (data, l);
+  des_store32 (data + 4, r);
+}
+
+void __attribute__ ((weak))
+des_run (uint8_t * data, uint8_t * main_key, uint8_t mode)
+{
+  des_ctx_t ctx;
+
+  des_ctx_init (&ctx, main_key, mode);
+  des_ctx_run (&ctx, data);
+  memset (&ctx, 0, sizeof (ctx));
+}
+#else
 /* *INDENT-OFF* */
 // not used key bits marked by /**/
 static TAB_TYPE message_perm[] = {	//
@@ -446,6 +749,7 @@ des3_run:
     goto des3_run;
 #endif
 }
+#endif
 
 #if ENABLE_DES56
 void __attribute__ ((weak)) des_56to64 (uint8_t * key)
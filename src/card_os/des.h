@@ -29,6 +29,19 @@
 #define DES_3DES            0x0c
 
 void des_run (uint8_t * data,  uint8_t *key, uint8_t mode);
+
+#ifdef DES_CTX
+// key schedule (16 rounds x 2 words) for DES or three for 3DES, reusable
+// for more blocks, mode (encipher/decipher, DES/3DES) is part of context
+typedef struct
+{
+  uint32_t ks[3][32];
+  uint8_t count;
+} des_ctx_t;
+
+void des_ctx_init (des_ctx_t * ctx, uint8_t * key, uint8_t mode);
+void des_ctx_run (des_ctx_t * ctx, uint8_t * data);
+#endif
 // transform 7 bytes of key to 8 bytes (with parity bits)
 void des_56to64 (uint8_t * key);
 #endif
@@ -56,11 +56,18 @@
 #include "rnd.h"
 #include "ec.h"
 #include "bn_lib.h"
+#ifdef CURVE25519
+#include "sha512.h"
+#endif
 
 #ifndef EC_BLIND
 #define EC_BLIND 0
 #endif
 
+#if defined (EC_GLV) && (defined (NIST_ONLY) || MP_BYTES < 32)
+#error EC_GLV needs secp256k1 support
+#endif
+
 #ifndef EC_MUL_WINDOW
 #define  EC_MUL_WINDOW 4
 #endif
@@ -746,11 +753,29 @@ field_sqr (bignum_t * r, bignum_t * a)
   field_reduction (r, &bn_tmp);
 }
 
+// r = X^3 + a * X + b (only for A=0 and A=-3)
+static void
+ec_curve_rhs (bignum_t * r, bignum_t * x, struct ec_param *ec)
+{
+  // X^2
+  field_sqr (r, x);
+  // X^3
+  field_mul (r, r, x);
+  // X^3 +b
+  field_add (r, &ec->b);
+  if (ec->curve_type & 0x40)
+    {
+      // -3 * X - all NIST curves
+      field_sub (r, x);
+      field_sub (r, x);
+      field_sub (r, x);
+    }
+}
+
 static uint8_t
 ec_is_point_affine (ec_point_t * p, struct ec_param *ec)
 {
   bignum_t yy;
-  bignum_t xx;
   bignum_t xxx;
 
 // only supported curves are checked, all others are handled as OK
@@ -758,19 +783,7 @@ ec_is_point_affine (ec_point_t * p, struct ec_param *ec)
     return 1;
   // Y^2
   field_sqr (&yy, &p->Y);
-  // X^2
-  field_sqr (&xx, &p->X);
-  // X^3
-  field_mul (&xxx, &xx, &p->X);
-  // X^3 -b
-  field_add (&xxx, &ec->b);
-  if (ec->curve_type & 0x40)
-    {
-      // -3 * X - all NIST curves
-      field_sub (&xxx, &p->X);
-      field_sub (&xxx, &p->X);
-      field_sub (&xxx, &p->X);
-    }
+  ec_curve_rhs (&xxx, &p->X, ec);
   mp_sub (&xxx, &xxx, &yy);
   return mp_is_zero (&xxx);
 }
@@ -951,6 +964,7 @@ ec_add (ec_point_t * a, ec_point_t * b)
 #undef H
 #undef R
 
+#if EC_MUL_WINDOW != 5
 //ec_full_add (R, S, T ): Set R to S+T . All points projective
 static void
 ec_full_add (ec_point_t * result, ec_point_t * s, ec_point_t * t)
@@ -960,7 +974,85 @@ ec_full_add (ec_point_t * result, ec_point_t * s, ec_point_t * t)
   memcpy (result, s, sizeof (ec_point_t));
   ec_add (result, t);
 }
+#endif
+
+
+#ifdef EC_SPECIALIZE
+// curve specific instances of field/point arithmetic (fixed length, fixed
+// reduction, no run time test of curve_type), see ec_instance.h
+#if defined (HAVE_RSA_SQUARE_384) && defined (HAVE_RSA_SQUARE_256) && defined (HAVE_RSA_SQUARE_192)
+#define EC_SQR_192(r,a) rsa_square_192 (&(r)->value[0], &(a)->value[0])
+#define EC_SQR_256(r,a) rsa_square_256 (&(r)->value[0], &(a)->value[0])
+#define EC_SQR_384(r,a) rsa_square_384 (&(r)->value[0], &(a)->value[0])
+#define EC_SQR_521(r,a) mp_square_521 (&(r)->value[0], &(a)->value[0])
+#else
+#define EC_SQR_192(r,a) mp_mul_192 (r, a, a)
+#define EC_SQR_256(r,a) mp_mul_256 (r, a, a)
+#define EC_SQR_384(r,a) mp_mul_384 (r, a, a)
+#define EC_SQR_521(r,a) mp_mul_521 (r, a, a)
+#endif
+
+#define EC_NAME(x)	x ## _p192
+#define EC_LEN		24
+#define EC_KEY_BYTES	24
+#define EC_MUL		mp_mul_192
+#define EC_SQR		EC_SQR_192
+#define EC_RED		fast192reduction
+#define EC_A		0x40
+#define EC_LAZY		1
+#include "ec_instance.h"
 
+#if MP_BYTES >= 32
+#define EC_NAME(x)	x ## _p256
+#define EC_LEN		32
+#define EC_KEY_BYTES	32
+#define EC_MUL		mp_mul_256
+#define EC_SQR		EC_SQR_256
+#define EC_RED		fast256reduction
+#define EC_A		0x40
+#define EC_LAZY		1
+#include "ec_instance.h"
+#ifndef NIST_ONLY
+#define EC_NAME(x)	x ## _k256
+#define EC_LEN		32
+#define EC_KEY_BYTES	32
+#define EC_MUL		mp_mul_256
+#define EC_SQR		EC_SQR_256
+#define EC_RED		secp256k1reduction
+#define EC_A		0x80
+#define EC_LAZY		1
+#include "ec_instance.h"
+#endif
+#endif
+
+#if MP_BYTES >= 48
+#define EC_NAME(x)	x ## _p384
+#define EC_LEN		48
+#define EC_KEY_BYTES	48
+#define EC_MUL		mp_mul_384
+#define EC_SQR		EC_SQR_384
+#define EC_RED		fast384reduction
+#define EC_A		0x40
+#define EC_LAZY		1
+#include "ec_instance.h"
+#endif
+
+#if MP_BYTES >= 66
+// fast521reduction () writes MP_BYTES bytes of result
+#if MP_BYTES != 72
+#error curve specific P521 arithmetic needs MP_BYTES 72
+#endif
+#define EC_NAME(x)	x ## _p521
+#define EC_LEN		72
+#define EC_KEY_BYTES	66
+#define EC_MUL		mp_mul_521
+#define EC_SQR		EC_SQR_521
+#define EC_RED		fast521reduction
+#define EC_A		0x40
+#define EC_LAZY		0
+#include "ec_instance.h"
+#endif
+#endif
 
 #if EC_MUL_WINDOW == 2
 // constant time - do ec_add into false result for zero bit(s) in k
@@ -1121,6 +1213,98 @@ ec_mul (ec_point_t * point, uint8_t * k)
     }
   memcpy (point, &r[0], sizeof (ec_point_t));
 }
+#elif EC_MUL_WINDOW == 5
+/*
+Signed window (Booth recoding), window up to 5 bits. Table of odd and even
+multiples 1*P .. 2^(w-1)*P is stored packed (3 * mp_get_len () bytes for
+each point) in arena of EC_MUL_ARENA bytes, window size is selected by
+number of points that fit into arena (default arena allows 5 bit window
+for 256 bit curves, 4 bit window for 384 bit and 3 bit for 521 bit curve).
+Digit 0 is handled by add into false result, negative digit by constant
+time negation of Y.
+*/
+#ifndef EC_MUL_ARENA
+#define EC_MUL_ARENA (16 * 3 * 32)
+#endif
+
+// return bits k[pos + w - 1 .. pos - 1] (bits below 0 and above key are 0)
+static uint8_t
+ec_mul_bits (uint8_t * k, int16_t pos, uint8_t w, uint8_t len)
+{
+  uint16_t val = 0;
+  int16_t i;
+
+  for (i = pos + w - 1; i >= pos - 1; i--)
+    {
+      val <<= 1;
+      if (i >= 0 && i < len * 8)
+	val |= (k[i / 8] >> (i & 7)) & 1;
+    }
+  return val;
+}
+
+static void
+ec_mul (ec_point_t * point, uint8_t * k)
+{
+  int16_t i;
+  uint8_t w, b, s, index, len, klen, j;
+  uint16_t stride;
+  uint8_t *entry;
+  bignum_t y;
+
+//  DPRINT ("%s\n", __FUNCTION__);
+
+  uint8_t table[EC_MUL_ARENA];
+  ec_point_t r[2];
+  ec_point_t t;
+
+  len = mp_get_len ();
+  stride = 3 * len;
+  for (w = 5; ((uint16_t) 1 << (w - 1)) * stride > EC_MUL_ARENA; w--);
+
+  klen = mp_get_len () + EC_BLIND;
+#if MP_BYTES >= 66
+  if (curve_type == (C_SECP521R1 | C_SECP521R1_MASK))
+    klen = 66 + EC_BLIND;
+#endif
+
+  // table: 1*P, 2*P .. 2^(w-1) * P
+  memcpy (&t, point, sizeof (ec_point_t));
+  for (entry = table, j = 1 << (w - 1);;)
+    {
+      memcpy (entry, &t.X, len);
+      memcpy (entry + len, &t.Y, len);
+      memcpy (entry + 2 * len, &t.Z, len);
+      entry += stride;
+      if (!(--j))
+	break;
+      ec_add (&t, point);
+    }
+
+  memcpy (&r[1], point, sizeof (ec_point_t));
+  memset (&r[0], 0, sizeof (ec_point_t));
+  memset (&t, 0, sizeof (ec_point_t));
+  for (i = (klen * 8) / w; i >= 0; i--)
+    {
+      for (j = 0; j < w; j++)
+	ec_double (&r[0]);
+      b = ec_mul_bits (k, i * w, w, klen);
+      // s = 0xff for negative digit
+      s = ~((b >> w) - 1);
+      b = (((((1 << (w + 1)) - b - 1) & s) | (b & ~s)) + 1) >> 1;
+      index = (b == 0);
+      b |= index;
+      entry = table + (b - 1) * stride;
+      memcpy (&t.X, entry, len);
+      memcpy (&t.Y, entry + len, len);
+      memcpy (&t.Z, entry + 2 * len, len);
+      mp_sub (&y, field_prime, &t.Y);
+      for (j = 0; j < len; j++)
+	t.Y.value[j] = (y.value[j] & s) | (t.Y.value[j] & ~s);
+      ec_add (&r[index], &t);
+    }
+  memcpy (point, &r[0], sizeof (ec_point_t));
+}
 #else
 #error Unknown EC_MUL_WINDOW
 #endif
@@ -1174,14 +1358,234 @@ static void
 }
 #endif
 
-// point = k * point
-static uint8_t
-ec_calc_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
+#ifdef EC_GLV
+/*
+GLV endomorphism for secp256k1: lambda * (x, y) = (beta * x, y).
+
+Scalar is decomposed as k = k1 + k2 * lambda (mod n) with k1, k2 about 128
+bits (babai rounding with precomputed g1 = round (2^384 * b2 / n) and
+g2 = round (2^384 * -b1 / n), (a1,b1), (a2,b2) is short lattice basis,
+b2 = a1). Both halves are blinded by the same random multiple of short
+lattice vector (a2, b2) - a2 + b2 * lambda = 0 (mod n), this also makes
+both halves positive (no point negation is needed). Then joint ladder
+(2 bits from each half) is used, number of doublings is (16 + blinding
+bytes) * 8 instead of (32 + blinding bytes) * 8.
+*/
+static const uint8_t glv_beta[32] = {
+  0xee, 0x01, 0x95, 0x71, 0x28, 0x6c, 0x39, 0xc1,
+  0x95, 0x89, 0xf5, 0x12, 0x75, 0x49, 0xf0, 0x9c,
+  0xe9, 0x34, 0x34, 0xac, 0x9e, 0x47, 0x64, 0x6e,
+  0x10, 0x07, 0x7c, 0x65, 0x2b, 0x6a, 0xe9, 0x7a,
+};
+
+static const uint8_t glv_lambda[32] = {
+  0x72, 0xbd, 0x23, 0x1b, 0x7c, 0x96, 0x02, 0xdf,
+  0x78, 0x66, 0x81, 0x20, 0xea, 0x22, 0x2e, 0x12,
+  0x5a, 0x64, 0x12, 0x88, 0x02, 0x1c, 0x26, 0xa5,
+  0xe0, 0x30, 0x5c, 0xc0, 0x4c, 0xad, 0x63, 0x53,
+};
+
+static const uint8_t glv_g1[32] = {
+  0x31, 0xb0, 0xdb, 0x45, 0x9a, 0x20, 0x93, 0xe8,
+  0x7f, 0xca, 0xe8, 0x71, 0x14, 0x8a, 0xaa, 0x3d,
+  0x15, 0xeb, 0x84, 0x92, 0xe4, 0x90, 0x6c, 0xe8,
+  0xcd, 0x6b, 0xd4, 0xa7, 0x21, 0xd2, 0x86, 0x30,
+};
+
+static const uint8_t glv_g2[32] = {
+  0x71, 0x7f, 0xc4, 0x8a, 0xae, 0xb4, 0x71, 0x15,
+  0xc6, 0x06, 0xf5, 0x9d, 0xac, 0x08, 0x12, 0x22,
+  0xc4, 0xe4, 0xbf, 0x0a, 0xa9, 0x7f, 0x54, 0x6f,
+  0x28, 0x88, 0x0e, 0x01, 0xd6, 0x7e, 0x43, 0xe4,
+};
+
+static const uint8_t glv_minus_b1[17] = {
+  0xc3, 0xe4, 0xbf, 0x0a, 0xa9, 0x7f, 0x54, 0x6f,
+  0x28, 0x88, 0x0e, 0x01, 0xd6, 0x7e, 0x43, 0xe4,
+  0x00,
+};
+
+static const uint8_t glv_a2[17] = {
+  0xd8, 0xcf, 0x44, 0x9d, 0x8d, 0x10, 0xc1, 0x57,
+  0xf6, 0xf3, 0xe2, 0xa8, 0xf7, 0x50, 0xca, 0x14,
+  0x01,
+};
+
+// b2 = a1
+static const uint8_t glv_b2[17] = {
+  0x15, 0xeb, 0x84, 0x92, 0xe4, 0x90, 0x6c, 0xe8,
+  0xcd, 0x6b, 0xd4, 0xa7, 0x21, 0xd2, 0x86, 0x30,
+  0x00,
+};
+
+// point arithmetic of GLV ladder (secp256k1 instance if available)
+#ifdef EC_SPECIALIZE
+#define glv_point_t point_t_k256
+#define glv_fe_t fe_t_k256
+#define glv_double ec_double_k256
+#define glv_add ec_add_k256
+#define glv_field_mul field_mul_k256
+#define glv_point_load ec_point_load_k256
+#define glv_point_store ec_point_store_k256
+#else
+#define glv_point_t ec_point_t
+#define glv_fe_t bignum_t
+#define glv_double ec_double
+#define glv_add ec_add
+#define glv_field_mul field_mul
+#define glv_point_load(r,p) memcpy (r, p, sizeof (ec_point_t))
+#define glv_point_store(p,r) memcpy (p, r, sizeof (ec_point_t))
+#endif
+
+// without blinding use constant R = 0x20 (R * (a2, b2) must be above 2^128)
+#if EC_BLIND > 0
+#define GLV_BLIND EC_BLIND
+#else
+#define GLV_BLIND 1
+#endif
+
+// r = a * c (c from ROM)
+static void
+glv_mul (bigbignum_t * r, bignum_t * a, const uint8_t * c, uint8_t len)
 {
-  uint8_t blind_key[sizeof (bignum_t) + 8];
+  bignum_t t;
+
+  memset (&t, 0, sizeof (bignum_t));
+  memcpy (&t, c, len);
+  mp_mul (r, a, &t);
+}
+
+// r = round (k * g / 2^384)
+static void
+glv_round (bignum_t * r, bignum_t * k, const uint8_t * g)
+{
+  bigbignum_t t;
+  bignum_t c;
+
+  glv_mul (&t, k, g, 32);
+  memset (r, 0, sizeof (bignum_t));
+  memcpy (r, &t.value[48], 16);
+  memset (&c, 0, sizeof (bignum_t));
+  c.value[0] = t.value[47] >> 7;
+  mp_add (r, &c);
+}
+
+// r = r * c (c from ROM, result below 2^256)
+static void
+glv_mul_short (bignum_t * r, const uint8_t * c)
+{
+  bigbignum_t t;
+
+  glv_mul (&t, r, c, 17);
+  memset (r, 0, sizeof (bignum_t));
+  memcpy (r, &t, 32);
+}
+
+// k = k (- n if k > n/2) + rnd * v, result is positive (calculated mod 2^256)
+static void
+glv_blind (bignum_t * k, bignum_t * rnd, const uint8_t * v, bignum_t * order)
+{
+  bignum_t n, t;
+  uint8_t i, mask;
+
+  memcpy (&n, order, sizeof (bignum_t));
+  mp_shiftr (&n);
+  mask = -mp_sub (&n, &n, k);
+  for (i = 0; i < 32; i++)
+    n.value[i] = order->value[i] & mask;
+  mp_sub (k, k, &n);
+  memcpy (&t, rnd, sizeof (bignum_t));
+  glv_mul_short (&t, v);
+  mp_add (k, &t);
+}
+
+static void
+ec_mul_glv (ec_point_t * point, bignum_t * k, bignum_t * order)
+{
+  int8_t i;
+  uint8_t b, b1, b2, j;
+  uint8_t index;
+  bignum_t k1, k2, t;
+  glv_fe_t beta;
 
   DPRINT ("%s\n", __FUNCTION__);
-  ec_set_param (ec);
+
+  glv_point_t data[17];		// 0 used as result, 1..16 as precomputed table
+
+  glv_point_t *r = &data[0];
+  glv_point_t *table = &data[1];	// table[i + 4 * j] = i * P + j * lambda * P
+
+// k2 = c1 * -b1 - c2 * b2 (mod n), both products are below n
+  glv_round (&k2, k, glv_g1);
+  glv_mul_short (&k2, glv_minus_b1);
+  glv_round (&t, k, glv_g2);
+  glv_mul_short (&t, glv_b2);
+  sub_mod (&k2, &t, order);
+// k1 = k - k2 * lambda (mod n)
+  memset (&t, 0, sizeof (bignum_t));
+  memcpy (&t, glv_lambda, 32);
+  mul_mod (&t, &k2, &t, order);
+  memcpy (&k1, k, sizeof (bignum_t));
+  sub_mod (&k1, &t, order);
+
+  memset (&t, 0, sizeof (bignum_t));
+#if EC_BLIND > 0
+  rnd_get ((uint8_t *) & t, EC_BLIND);
+#endif
+  t.value[GLV_BLIND - 1] &= 0x3f;
+  t.value[GLV_BLIND - 1] |= 0x20;
+  glv_blind (&k1, &t, glv_a2, order);
+  glv_blind (&k2, &t, glv_b2, order);
+
+  glv_point_load (&table[1], point);
+  memcpy (&table[2], &table[1], sizeof (glv_point_t));
+  glv_double (&table[2]);
+  memcpy (&table[3], &table[2], sizeof (glv_point_t));
+  glv_add (&table[3], &table[1]);
+  memset (&beta, 0, sizeof (glv_fe_t));
+  memcpy (&beta, glv_beta, 32);
+  for (index = 1; index < 4; index++)
+    {
+      memcpy (&table[4 * index], &table[index], sizeof (glv_point_t));
+      glv_field_mul (&table[4 * index].X, &table[index].X, &beta);
+    }
+  for (index = 4; index < 16; index += 4)
+    for (j = 1; j < 4; j++)
+      {
+	memcpy (&table[index + j], &table[index], sizeof (glv_point_t));
+	glv_add (&table[index + j], &table[j]);
+      }
+
+  memcpy (&r[1], &table[2], sizeof (glv_point_t));
+  memset (&r[0], 0, sizeof (glv_point_t));
+  for (i = 16 + GLV_BLIND - 1; i >= 0; i--)
+    {
+      b1 = k1.value[i];
+      b2 = k2.value[i];
+      for (j = 0; j < 4; j++)
+	{
+	  glv_double (&r[0]);
+	  glv_double (&r[0]);
+	  b = (b1 >> 6) | ((b2 >> 4) & 0x0c);
+	  index = (b == 0);
+	  b |= index;
+	  glv_add (&r[index], &table[b]);
+	  b1 <<= 2;
+	  b2 <<= 2;
+	}
+    }
+#ifdef EC_SPECIALIZE
+  ec_point_canon_k256 (&r[0]);
+#endif
+  glv_point_store (point, &r[0]);
+}
+#endif
+
+// point = k * point, result in projective representation
+static uint8_t
+ec_mul_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
+{
+  uint8_t blind_key[sizeof (bignum_t) + 8];
 
   if (mp_is_zero (k))
     return 1;
@@ -1190,6 +1594,14 @@ ec_calc_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
   if (mp_cmpGE (k, &ec->order))
     return 1;
 
+#ifdef EC_GLV
+  if (ec->curve_type == (C_SECP256K1 | C_SECP256K1_MASK))
+    {
+      ec_projectify (point);
+      ec_mul_glv (point, k, &(ec->order));
+      return 0;
+    }
+#endif
   memset (blind_key, 0, sizeof (blind_key));
   mp_set (blind_key, k);
 #if EC_BLIND > 0
@@ -1199,7 +1611,47 @@ ec_calc_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
   DPRINT ("multiplication\n");
 
   ec_projectify (point);
+#ifdef EC_SPECIALIZE
+  switch (ec->curve_type)
+    {
+    case C_P192V1 | C_P192V1_MASK:
+      ec_mul_p192 (point, blind_key);
+      return 0;
+#if MP_BYTES >= 32
+    case C_P256V1 | C_P256V1_MASK:
+      ec_mul_p256 (point, blind_key);
+      return 0;
+#ifndef NIST_ONLY
+    case C_SECP256K1 | C_SECP256K1_MASK:
+      ec_mul_k256 (point, blind_key);
+      return 0;
+#endif
+#endif
+#if MP_BYTES >= 48
+    case C_SECP384R1 | C_SECP384R1_MASK:
+      ec_mul_p384 (point, blind_key);
+      return 0;
+#endif
+#if MP_BYTES >= 66
+    case C_SECP521R1 | C_SECP521R1_MASK:
+      ec_mul_p521 (point, blind_key);
+      return 0;
+#endif
+    }
+#endif
   ec_mul (point, blind_key);
+  return 0;
+}
+
+// point = k * point
+static uint8_t
+ec_calc_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
+{
+  DPRINT ("%s\n", __FUNCTION__);
+  ec_set_param (ec);
+
+  if (ec_mul_key (k, point, ec))
+    return 1;
 
   if (ec_affinify (point, ec))
     return 1;
@@ -1213,6 +1665,251 @@ ec_calc_key (bignum_t * k, ec_point_t * point, struct ec_param *ec)
 }
 
 
+/*
+Calculate Y from X (SEC1 compressed point, y_bit = lowest bit of Y)
+Y = (X^3 + a * X + b)^((p + 1) / 4), all supported curves have p = 3 mod 4,
+(Tonelli-Shanks is not needed). X is public, exponentiation is not constant
+time.
+*/
+uint8_t
+ec_point_decompress (ec_point_t * point, uint8_t y_bit, struct ec_param *ec)
+{
+  bignum_t rhs, e;
+  uint16_t i;
+
+  DPRINT ("%s\n", __FUNCTION__);
+  ec_set_param (ec);
+
+  if (!(ec->curve_type & 0xc0))
+    return 1;
+  if ((ec->prime.value[0] & 3) != 3)
+    return 1;
+  if (mp_cmpGE (&point->X, &ec->prime))
+    return 1;
+
+  ec_curve_rhs (&rhs, &point->X, ec);
+
+  // e = (p + 1) / 4
+  memset (&e, 0, sizeof (bignum_t));
+  e.value[0] = 1;
+  mp_add (&e, &ec->prime);
+  mp_shiftr (&e);
+  mp_shiftr (&e);
+
+  memset (&point->Y, 0, sizeof (bignum_t));
+  point->Y.value[0] = 1;
+  i = mp_get_len () * 8;
+  while (i--)
+    {
+      field_sqr (&point->Y, &point->Y);
+      if ((e.value[i / 8] >> (i & 7)) & 1)
+	field_mul (&point->Y, &point->Y, &rhs);
+    }
+  // check Y^2 = rhs, (no square root exists for X not on curve)
+  field_sqr (&e, &point->Y);
+  mp_sub (&e, &e, &rhs);
+  if (!mp_is_zero (&e))
+    return 1;
+  if ((point->Y.value[0] & 1) != (y_bit & 1))
+    {
+      // Y = p - Y (Y = 0 is not valid for y_bit = 1)
+      if (mp_is_zero (&point->Y))
+	return 1;
+      memcpy (&e, &ec->prime, sizeof (bignum_t));
+      mp_sub (&point->Y, &e, &point->Y);
+    }
+  return 0;
+}
+
+#ifdef EC_COZ_LADDER
+/*
+Co-Z Montgomery ladder (Goundar, Joye, Miyaji: Co-Z addition formulae and
+binary ladders on elliptic curves), only X of result is calculated.
+
+Both points R0, R1 share the same Z (Z is not stored at all), every bit is
+processed by XYCZ-ADDC and XYCZ-ADD (no doubling), points are swapped by
+constant time swap. Scalar is regularized (k + n or k + 2n) to get fixed
+top bit, initial Z is random (projective randomization).
+*/
+
+// constant time swap of X,Y in r0, r1
+static void
+ec_coz_swap (ec_point_t * r0, ec_point_t * r1, uint8_t swap)
+{
+  uint8_t i, t, mask = -swap;
+
+  for (i = 0; i < mp_get_len (); i++)
+    {
+      t = mask & (r0->X.value[i] ^ r1->X.value[i]);
+      r0->X.value[i] ^= t;
+      r1->X.value[i] ^= t;
+      t = mask & (r0->Y.value[i] ^ r1->Y.value[i]);
+      r0->Y.value[i] ^= t;
+      r1->Y.value[i] ^= t;
+    }
+}
+
+// XYCZ-ADD: p, q (co-Z) -> p (same point, new Z), q = p + q
+static void
+ec_coz_add (ec_point_t * p, ec_point_t * q)
+{
+  bignum_t t;
+
+  memcpy (&t, &q->X, sizeof (bignum_t));
+  field_sub (&t, &p->X);
+  field_sqr (&t, &t);		// A = (x2 - x1)^2
+  field_mul (&p->X, &p->X, &t);	// B = x1 * A
+  field_mul (&q->X, &q->X, &t);	// C = x2 * A
+  field_sub (&q->Y, &p->Y);	// y2 - y1
+  field_sqr (&t, &q->Y);	// D = (y2 - y1)^2
+  field_sub (&t, &p->X);
+  field_sub (&t, &q->X);	// x3 = D - B - C
+  field_sub (&q->X, &p->X);	// C - B
+  field_mul (&p->Y, &p->Y, &q->X);	// y1' = y1 * (C - B)
+  memcpy (&q->X, &p->X, sizeof (bignum_t));
+  field_sub (&q->X, &t);	// B - x3
+  field_mul (&q->Y, &q->Y, &q->X);
+  field_sub (&q->Y, &p->Y);	// y3 = (y2 - y1) * (B - x3) - y1'
+  memcpy (&q->X, &t, sizeof (bignum_t));
+}
+
+// XYCZ-ADDC: p, q (co-Z) -> p = p - q, q = p + q
+static void
+ec_coz_addc (ec_point_t * p, ec_point_t * q)
+{
+  bignum_t t5, t6, t7;
+
+  memcpy (&t5, &q->X, sizeof (bignum_t));
+  field_sub (&t5, &p->X);
+  field_sqr (&t5, &t5);		// A = (x2 - x1)^2
+  field_mul (&p->X, &p->X, &t5);	// B = x1 * A
+  field_mul (&q->X, &q->X, &t5);	// C = x2 * A
+  memcpy (&t5, &q->Y, sizeof (bignum_t));
+  field_add (&t5, &p->Y);	// y2 + y1
+  field_sub (&q->Y, &p->Y);	// y2 - y1
+
+  memcpy (&t6, &q->X, sizeof (bignum_t));
+  field_sub (&t6, &p->X);	// C - B
+  field_mul (&p->Y, &p->Y, &t6);	// E = y1 * (C - B)
+  memcpy (&t6, &p->X, sizeof (bignum_t));
+  field_add (&t6, &q->X);	// B + C
+  field_sqr (&q->X, &q->Y);	// D = (y2 - y1)^2
+  field_sub (&q->X, &t6);	// x3 = D - (B + C)
+
+  memcpy (&t7, &p->X, sizeof (bignum_t));
+  field_sub (&t7, &q->X);	// B - x3
+  field_mul (&q->Y, &q->Y, &t7);
+  field_sub (&q->Y, &p->Y);	// y3 = (y2 - y1) * (B - x3) - E
+
+  field_sqr (&t7, &t5);		// F = (y2 + y1)^2
+  field_sub (&t7, &t6);		// x3' = F - (B + C)
+  memcpy (&t6, &t7, sizeof (bignum_t));
+  field_sub (&t6, &p->X);	// x3' - B
+  field_mul (&t6, &t6, &t5);
+  field_sub (&t6, &p->Y);	// y3' = (y2 + y1) * (x3' - B) - E
+  memcpy (&p->Y, &t6, sizeof (bignum_t));
+  memcpy (&p->X, &t7, sizeof (bignum_t));
+}
+
+// point->X = X of k * point (affine), point->Y is cleared
+static uint8_t
+ec_coz_mul_x (bignum_t * k, ec_point_t * point, struct ec_param *ec)
+{
+  uint8_t kk[2][sizeof (bignum_t) + 8];
+  uint8_t len, xlen, mask, b, swap, i;
+  int16_t bits, j;
+  ec_point_t r[2];
+  bignum_t x, y, z;
+
+  if (mp_is_zero (k))
+    return 1;
+  if (mp_cmpGE (k, &ec->order))
+    return 1;
+
+  // regularize scalar, kk[0] = k + n or kk[1] = k + 2n (bit "bits" is set)
+  len = mp_get_len ();
+  for (bits = len * 8 - 1; bits > 0; bits--)
+    if ((ec->order.value[bits / 8] >> (bits & 7)) & 1)
+      break;
+  bits++;
+  xlen = len + 8 <= MP_BYTES ? len + 8 : len;
+  memset (kk, 0, sizeof (kk));
+  memcpy (kk[0], k, len);
+  memcpy (&x, &ec->order, sizeof (bignum_t));
+  mp_set_len (xlen);
+  mp_add ((bignum_t *) kk[0], &x);
+  memcpy (kk[1], kk[0], sizeof (kk[0]));
+  mp_add ((bignum_t *) kk[1], &x);
+  mp_set_len (len);
+  mask = -((kk[0][bits / 8] >> (bits & 7)) & 1);
+  for (i = 0; i < sizeof (kk[0]); i++)
+    kk[0][i] = (kk[0][i] & mask) | (kk[1][i] & ~mask);
+
+  // affine input point
+  memcpy (&x, &point->X, sizeof (bignum_t));
+  memcpy (&y, &point->Y, sizeof (bignum_t));
+
+  // random initial Z (below p), R1 = (X * Z^2, Y * Z^3, Z)
+  memset (&z, 0, sizeof (bignum_t));
+#if EC_BLIND > 0
+  rnd_get ((uint8_t *) & z, ec->mp_size - 1);
+#endif
+  z.value[0] |= mp_is_zero (&z);
+  memcpy (&r[1].Z, &z, sizeof (bignum_t));
+  field_sqr (&z, &z);
+  field_mul (&r[1].X, &x, &z);
+  field_mul (&z, &z, &r[1].Z);
+  field_mul (&r[1].Y, &y, &z);
+  // R1 = 2P, R0 = P (same Z)
+  memcpy (&r[0], &r[1], sizeof (ec_point_t));
+  ec_double (&r[1]);
+  field_sqr (&z, &r[1].Z);
+  field_mul (&r[0].X, &x, &z);
+  field_mul (&z, &z, &r[1].Z);
+  field_mul (&r[0].Y, &y, &z);
+
+  swap = 0;
+  for (j = bits - 1; j >= 0; j--)
+    {
+      // b = 1 for zero bit, R[1 - b] in r[1], R[b] in r[0]
+      b = ((kk[0][j / 8] >> (j & 7)) & 1) ^ 1;
+      ec_coz_swap (&r[0], &r[1], swap ^ b);
+      swap = b;
+      ec_coz_addc (&r[1], &r[0]);
+      if (!j)
+	break;
+      ec_coz_add (&r[0], &r[1]);
+    }
+  // r[1] = +/- P, Z^-1 (up to sign) = (X1 * y) / ((X1 - X0) * Y1 * x)
+  // (X1 - X0) is Z factor from last ec_coz_add ()
+  memcpy (&z, &r[1].X, sizeof (bignum_t));
+  field_sub (&z, &r[0].X);
+  field_mul (&z, &z, &r[1].Y);
+  field_mul (&z, &z, &x);
+  if (mp_is_zero (&z))
+    return 1;
+  mp_inv_mod (&z, &z, &ec->prime);
+  field_mul (&z, &z, &y);
+  field_mul (&z, &z, &r[1].X);
+
+  ec_coz_add (&r[0], &r[1]);
+  ec_coz_swap (&r[0], &r[1], swap);
+
+  field_sqr (&z, &z);
+  memset (point, 0, sizeof (ec_point_t));
+  field_mul (&point->X, &r[0].X, &z);
+
+  memset (kk, 0, sizeof (kk));
+  memset (&r, 0, sizeof (r));
+
+  if (mp_is_zero (&(point->X)))
+    return 1;
+  if (mp_cmpGE (&(point->X), &ec->order))
+    return 1;
+  return 0;
+}
+#endif
+
 uint8_t
 ec_derive_key (ec_point_t * pub_key, struct ec_param *ec)
 {
@@ -1222,7 +1919,11 @@ ec_derive_key (ec_point_t * pub_key, struct ec_param *ec)
   if (!(ec_is_point_affine (pub_key, ec)))
     return 1;
 
+#ifdef EC_COZ_LADDER
+  return ec_coz_mul_x (&ec->working_key, pub_key, ec);
+#else
   return ec_calc_key (&ec->working_key, pub_key, ec);
+#endif
 }
 
 
@@ -1252,6 +1953,715 @@ ec_key_gener (ec_point_t * pub_key, struct ec_param *ec)
   return 1;
 }
 
+#ifdef CURVE25519
+/*
+X25519 (RFC 7748) - x-only Montgomery ladder on curve25519
+
+All numbers are in little endian (RFC 7748 byte order is same as bignum_t
+byte order), only 32 bytes of bignum_t are used. Field arithmetic use
+generic mp_mul/mp_square and add_mod/sub_mod, reduction by 2^255-19 is
+done by x25519_reduction() (not by field_reduction(), this can be
+overriden by ASM code for NIST curves).
+*/
+
+// r = bn mod 2^255-19 (2^256 = 38 mod p)
+static void
+x25519_reduction (bignum_t * r, bigbignum_t * bn)
+{
+  uint8_t i, mask;
+  uint16_t c = 0;
+  uint8_t t[32];
+
+  for (i = 0; i < 32; i++)
+    {
+      c += bn->value[i] + 38 * bn->value[i + 32];
+      r->value[i] = c;
+      c >>= 8;
+    }
+  // fold carry (c <= 38) and bit 255
+  c = (c << 1) | (r->value[31] >> 7);
+  r->value[31] &= 0x7f;
+  c *= 19;
+  for (i = 0; i < 32; i++)
+    {
+      c += r->value[i];
+      r->value[i] = c;
+      c >>= 8;
+    }
+  // r < 2^255 + small number, final subtraction (constant time)
+  // t = r + 19, if bit 255 in t is set, r >= p, use t - 2^255
+  c = 19;
+  for (i = 0; i < 32; i++)
+    {
+      c += r->value[i];
+      t[i] = c;
+      c >>= 8;
+    }
+  mask = -(t[31] >> 7);
+  t[31] &= 0x7f;
+  for (i = 0; i < 32; i++)
+    r->value[i] = (t[i] & mask) | (r->value[i] & ~mask);
+  memset (&r->value[32], 0, MP_BYTES - 32);
+}
+
+static void
+x25519_mul (bignum_t * r, bignum_t * a, bignum_t * b)
+{
+  mp_mul (&bn_tmp, a, b);
+  x25519_reduction (r, &bn_tmp);
+}
+
+// r = a^(2^n)
+static void
+x25519_sqr_n (bignum_t * r, bignum_t * a, uint8_t n)
+{
+  memcpy (r, a, sizeof (bignum_t));
+  while (n--)
+    {
+      mp_square (&bn_tmp, r);
+      x25519_reduction (r, &bn_tmp);
+    }
+}
+
+// r = z^(p-2), (p-2 = 2^255 - 21), constant time
+static void
+x25519_invert (bignum_t * r, bignum_t * z)
+{
+  bignum_t t0, t1, t2, t3;
+
+  x25519_sqr_n (&t0, z, 1);	// z^2
+  x25519_sqr_n (&t1, &t0, 2);	// z^8
+  x25519_mul (&t1, &t1, z);	// z^9
+  x25519_mul (&t0, &t0, &t1);	// z^11
+  x25519_sqr_n (&t2, &t0, 1);	// z^22
+  x25519_mul (&t1, &t1, &t2);	// z^(2^5 - 1)
+  x25519_sqr_n (&t2, &t1, 5);
+  x25519_mul (&t1, &t2, &t1);	// z^(2^10 - 1)
+  x25519_sqr_n (&t2, &t1, 10);
+  x25519_mul (&t2, &t2, &t1);	// z^(2^20 - 1)
+  x25519_sqr_n (&t3, &t2, 20);
+  x25519_mul (&t2, &t3, &t2);	// z^(2^40 - 1)
+  x25519_sqr_n (&t2, &t2, 10);
+  x25519_mul (&t1, &t2, &t1);	// z^(2^50 - 1)
+  x25519_sqr_n (&t2, &t1, 50);
+  x25519_mul (&t2, &t2, &t1);	// z^(2^100 - 1)
+  x25519_sqr_n (&t3, &t2, 100);
+  x25519_mul (&t2, &t3, &t2);	// z^(2^200 - 1)
+  x25519_sqr_n (&t2, &t2, 50);
+  x25519_mul (&t1, &t2, &t1);	// z^(2^250 - 1)
+  x25519_sqr_n (&t1, &t1, 5);
+  x25519_mul (r, &t1, &t0);	// z^(2^255 - 21)
+}
+
+static void
+x25519_cswap (bignum_t * a, bignum_t * b, uint8_t swap)
+{
+  uint8_t i, t, mask = -swap;
+
+  for (i = 0; i < 32; i++)
+    {
+      t = mask & (a->value[i] ^ b->value[i]);
+      a->value[i] ^= t;
+      b->value[i] ^= t;
+    }
+}
+
+// set field prime 2^255-19 and arithmetic length, return previous
+// field_prime (p is on caller stack, caller must restore field_prime)
+static bignum_t *
+x25519_field_init (bignum_t * p)
+{
+  bignum_t *prev = field_prime;
+
+  mp_set_len (32);
+  memset (p, 0xff, 32);
+  p->value[0] = 0xed;
+  p->value[31] = 0x7f;
+  memset (&p->value[32], 0, MP_BYTES - 32);
+  field_prime = p;
+  return prev;
+}
+
+// result = X25519(scalar, u), return 1 if result is zero (small order u)
+uint8_t
+x25519 (bignum_t * result, bignum_t * scalar, bignum_t * u)
+{
+  bignum_t p, k, x1, x2, z2, x3, z3, a, c, a24;
+  bignum_t *prev_prime;
+  uint8_t i, bit, swap = 0;
+
+  DPRINT ("%s\n", __FUNCTION__);
+
+  prev_prime = x25519_field_init (&p);
+
+  memset (&a24, 0, sizeof (bignum_t));
+  a24.value[0] = 121665 & 0xff;
+  a24.value[1] = (121665 >> 8) & 0xff;
+  a24.value[2] = 121665 >> 16;
+
+  // clamp scalar
+  memset (&k, 0, sizeof (bignum_t));
+  memcpy (&k, scalar, 32);
+  k.value[0] &= 0xf8;
+  k.value[31] &= 0x7f;
+  k.value[31] |= 0x40;
+
+  // mask bit 255 of u, reduce non canonical u
+  memset (&bn_tmp, 0, sizeof (bigbignum_t));
+  memcpy (&bn_tmp, u, 32);
+  bn_tmp.value[31] &= 0x7f;
+  x25519_reduction (&x1, &bn_tmp);
+
+  memset (&x2, 0, sizeof (bignum_t));
+  x2.value[0] = 1;
+  memset (&z2, 0, sizeof (bignum_t));
+  memcpy (&x3, &x1, sizeof (bignum_t));
+  memcpy (&z3, &x2, sizeof (bignum_t));
+
+  i = 255;
+  do
+    {
+      i--;
+      bit = (k.value[i / 8] >> (i & 7)) & 1;
+      swap ^= bit;
+      x25519_cswap (&x2, &x3, swap);
+      x25519_cswap (&z2, &z3, swap);
+      swap = bit;
+
+      memcpy (&a, &x2, sizeof (bignum_t));
+      field_add (&a, &z2);	// A = x2 + z2
+      field_sub (&x2, &z2);	// B = x2 - z2
+      memcpy (&c, &x3, sizeof (bignum_t));
+      field_add (&c, &z3);	// C = x3 + z3
+      field_sub (&x3, &z3);	// D = x3 - z3
+      x25519_mul (&x3, &x3, &a);	// DA
+      x25519_mul (&c, &c, &x2);	// CB
+      x25519_sqr_n (&a, &a, 1);	// AA
+      x25519_sqr_n (&x2, &x2, 1);	// BB
+      memcpy (&z3, &x3, sizeof (bignum_t));
+      field_sub (&z3, &c);	// DA - CB
+      field_add (&x3, &c);	// DA + CB
+      x25519_sqr_n (&x3, &x3, 1);	// x3 = (DA + CB)^2
+      x25519_sqr_n (&z3, &z3, 1);
+      x25519_mul (&z3, &z3, &x1);	// z3 = x1 * (DA - CB)^2
+      memcpy (&z2, &a, sizeof (bignum_t));
+      field_sub (&z2, &x2);	// E = AA - BB
+      x25519_mul (&x2, &a, &x2);	// x2 = AA * BB
+      x25519_mul (&c, &z2, &a24);
+      field_add (&c, &a);	// AA + a24 * E
+      x25519_mul (&z2, &z2, &c);	// z2 = E * (AA + a24 * E)
+    }
+  while (i);
+  x25519_cswap (&x2, &x3, swap);
+  x25519_cswap (&z2, &z3, swap);
+
+  x25519_invert (&z2, &z2);
+  x25519_mul (result, &x2, &z2);
+
+  memset (&k, 0, sizeof (bignum_t));
+  memset (&a, 0, sizeof (bignum_t));
+  memset (&c, 0, sizeof (bignum_t));
+  memset (&x2, 0, sizeof (bignum_t));
+  memset (&z2, 0, sizeof (bignum_t));
+  memset (&x3, 0, sizeof (bignum_t));
+  memset (&z3, 0, sizeof (bignum_t));
+  field_prime = prev_prime;
+
+  if (mp_is_zero (result))
+    {
+      DPRINT ("zero result, small order point\n");
+      return 1;
+    }
+  return 0;
+}
+
+// generate private key, return public key (u coordinate)
+uint8_t
+x25519_key_gener (bignum_t * pub_key, bignum_t * priv_key)
+{
+  bignum_t base;
+
+  DPRINT ("%s\n", __FUNCTION__);
+
+  memset (&base, 0, sizeof (bignum_t));
+  base.value[0] = 9;
+  memset (priv_key, 0, sizeof (bignum_t));
+  rnd_get ((uint8_t *) priv_key, 32);
+  return x25519 (pub_key, priv_key, &base);
+}
+
+/*
+Ed25519 (RFC 8032) - sign and key generation only
+
+Points are in extended twisted Edwards coordinates (X:Y:Z:T), x = X/Z,
+y = Y/Z, x * y = T/Z, curve -x^2 + y^2 = 1 + d * x^2 * y^2. Field
+arithmetic is shared with X25519.  Base point multiplication uses a comb
+with 4 teeth (64 doublings and 64 additions), table holds all 15 non zero
+combinations of B, 2^64 B, 2^128 B, 2^192 B in (y+x, y-x, 2dxy) form.
+*/
+typedef struct
+{
+  bignum_t X;
+  bignum_t Y;
+  bignum_t Z;
+  bignum_t T;
+} ed_point_t;
+
+// (y + x, y - x, 2 * d * x * y), little endian
+static const uint8_t ed25519_comb[15][96] = {
+  {
+    0x85, 0x3b, 0x8c, 0xf5, 0xc6, 0x93, 0xbc, 0x2f, 0x19, 0x0e, 0x8c, 0xfb,
+    0xc6, 0x2d, 0x93, 0xcf, 0xc2, 0x42, 0x3d, 0x64, 0x98, 0x48, 0x0b, 0x27,
+    0x65, 0xba, 0xd4, 0x33, 0x3a, 0x9d, 0xcf, 0x07, 0x3e, 0x91, 0x40, 0xd7,
+    0x05, 0x39, 0x10, 0x9d, 0xb3, 0xbe, 0x40, 0xd1, 0x05, 0x9f, 0x39, 0xfd,
+    0x09, 0x8a, 0x8f, 0x68, 0x34, 0x84, 0xc1, 0xa5, 0x67, 0x12, 0xf8, 0x98,
+    0x92, 0x2f, 0xfd, 0x44, 0x68, 0xaa, 0x7a, 0x87, 0x05, 0x12, 0xc9, 0xab,
+    0x9e, 0xc4, 0xaa, 0xcc, 0x23, 0xe8, 0xd9, 0x26, 0x8c, 0x59, 0x43, 0xdd,
+    0xcb, 0x7d, 0x1b, 0x5a, 0xa8, 0x65, 0x0c, 0x9f, 0x68, 0x7b, 0x11, 0x6f
+  },
+  {
+    0x15, 0xf5, 0xd1, 0x77, 0xe7, 0x65, 0x2a, 0xcd, 0xf1, 0x60, 0xaa, 0x8f,
+    0x87, 0x91, 0x89, 0x54, 0xe5, 0x06, 0xbc, 0xda, 0xbc, 0x3b, 0xb7, 0xb1,
+    0xfb, 0xc9, 0x7c, 0xa9, 0xcb, 0x78, 0x48, 0x65, 0xfe, 0xb0, 0xf6, 0x8d,
+    0xc7, 0x8e, 0x13, 0x51, 0x1b, 0xf5, 0x75, 0xe5, 0x89, 0xda, 0x97, 0x53,
+    0xb9, 0xf1, 0x7a, 0x71, 0x1d, 0x7a, 0x20, 0x09, 0x50, 0xd6, 0x20, 0x2b,
+    0xba, 0xfd, 0x02, 0x21, 0xa1, 0xe6, 0x5c, 0x05, 0x05, 0xe4, 0x9e, 0x96,
+    0x29, 0xad, 0x51, 0x12, 0x68, 0xa7, 0xbc, 0x36, 0x15, 0xa4, 0x7d, 0xaa,
+    0x17, 0xf5, 0x1a, 0x3a, 0xba, 0xb2, 0xec, 0x29, 0xdb, 0x25, 0xd7, 0x0a
+  },
+  {
+    0xe8, 0x59, 0x1e, 0x60, 0x85, 0xc5, 0x55, 0x00, 0x60, 0x0e, 0x48, 0x66,
+    0x2b, 0x34, 0x93, 0x87, 0x4c, 0xe4, 0x45, 0xfe, 0xd0, 0xaa, 0x14, 0x3e,
+    0x2b, 0xcf, 0x13, 0x48, 0xe6, 0xd8, 0xea, 0x26, 0xa4, 0x62, 0x84, 0x9c,
+    0xb6, 0xb8, 0x75, 0xcb, 0xd7, 0x1c, 0xd3, 0x67, 0xc5, 0x6f, 0xd8, 0x2d,
+    0xf6, 0x42, 0x13, 0x88, 0xec, 0x72, 0x19, 0xcd, 0x2f, 0x2f, 0xc1, 0x0f,
+    0x97, 0xb5, 0x75, 0x09, 0x43, 0xa7, 0x5b, 0xda, 0x03, 0x23, 0xcf, 0x63,
+    0x6e, 0xba, 0xf1, 0x52, 0x81, 0x9d, 0xbf, 0x04, 0xda, 0x67, 0x73, 0xaa,
+    0xd0, 0x90, 0x37, 0x33, 0xea, 0xc5, 0xf6, 0x9d, 0x47, 0x70, 0x46, 0x53
+  },
+  {
+    0xa2, 0x8e, 0xad, 0xac, 0xbf, 0x04, 0x3b, 0x58, 0x84, 0xe8, 0x8b, 0x14,
+    0xe8, 0x43, 0xb7, 0x29, 0xdb, 0xc5, 0x10, 0x08, 0x3b, 0x58, 0x1e, 0x2b,
+    0xaa, 0xbb, 0xb3, 0x8e, 0xe5, 0x49, 0x54, 0x2b, 0x47, 0xbe, 0x3d, 0xeb,
+    0x62, 0x75, 0x3a, 0x5f, 0xb8, 0xa0, 0xbd, 0x8e, 0x54, 0x38, 0xea, 0xf7,
+    0x99, 0x72, 0x74, 0x45, 0x31, 0xe5, 0xc3, 0x00, 0x51, 0xd5, 0x27, 0x16,
+    0xe7, 0xe9, 0x04, 0x13, 0xfe, 0x9c, 0xdc, 0x6a, 0xd2, 0x14, 0x98, 0x78,
+    0x0b, 0xdd, 0x48, 0x8b, 0x3f, 0xab, 0x1b, 0x3c, 0x0a, 0xc6, 0x79, 0xf9,
+    0xff, 0xe1, 0x0f, 0xda, 0x93, 0xd6, 0x2d, 0x7c, 0x2d, 0xde, 0x68, 0x44
+  },
+  {
+    0x48, 0x67, 0xbc, 0xe3, 0x8d, 0x27, 0x18, 0x21, 0xf7, 0x0e, 0xb2, 0xd0,
+    0x60, 0xfd, 0x1f, 0xe7, 0x98, 0xb1, 0x7b, 0xc6, 0x51, 0xbe, 0x51, 0xf5,
+    0x4d, 0x3d, 0x54, 0xd0, 0x64, 0x36, 0xa1, 0x26, 0xee, 0x39, 0xa3, 0x13,
+    0x3b, 0x2d, 0x52, 0x29, 0x29, 0x95, 0xd8, 0x6c, 0x50, 0x25, 0x52, 0x85,
+    0xf1, 0xf0, 0xf4, 0xac, 0xd4, 0x3a, 0xea, 0xdf, 0x2e, 0x74, 0x42, 0x79,
+    0xba, 0x6b, 0xd7, 0x49, 0x1d, 0xe6, 0x56, 0x8d, 0x33, 0x42, 0xfa, 0x14,
+    0x9a, 0x29, 0x51, 0xc3, 0x46, 0x39, 0x1d, 0x19, 0x85, 0xb1, 0xad, 0xa7,
+    0x6d, 0x57, 0x7d, 0x24, 0xc2, 0xed, 0xfc, 0xa8, 0xe3, 0xaf, 0x1f, 0x4e
+  },
+  {
+    0x4c, 0x04, 0x6a, 0x23, 0x3d, 0x05, 0xe7, 0x15, 0xe3, 0x87, 0x8d, 0x3b,
+    0xb1, 0xbc, 0xdd, 0x3c, 0x28, 0xa8, 0x21, 0xd3, 0xd2, 0x60, 0x99, 0x51,
+    0xa4, 0xbb, 0xc5, 0x0f, 0x0f, 0x9a, 0x55, 0x4e, 0x1c, 0x70, 0x12, 0x9c,
+    0x76, 0xe8, 0x00, 0xfe, 0x5f, 0x3b, 0x9c, 0x03, 0x0a, 0xdc, 0xdc, 0x95,
+    0x1b, 0xeb, 0x02, 0x0c, 0x4b, 0x45, 0x69, 0xc1, 0x0c, 0x53, 0x87, 0x5f,
+    0xd3, 0x21, 0x70, 0x72, 0x1e, 0x24, 0xdf, 0x27, 0x07, 0x04, 0x71, 0xa5,
+    0x36, 0x0d, 0x90, 0xb2, 0xaa, 0xef, 0x45, 0xdf, 0xde, 0x9a, 0xa6, 0x60,
+    0x5c, 0xdb, 0x6e, 0xfe, 0x1d, 0xc0, 0xbb, 0x07, 0x30, 0xb7, 0xfc, 0x64
+  },
+  {
+    0xca, 0x90, 0xd3, 0x6f, 0xcc, 0x58, 0xef, 0x38, 0xfc, 0x98, 0x1a, 0x17,
+    0x75, 0x65, 0x78, 0xef, 0x5f, 0xd6, 0x42, 0xc4, 0x8f, 0xb7, 0x50, 0x88,
+    0xef, 0x86, 0xd0, 0x6f, 0x6d, 0xc6, 0x34, 0x6f, 0x04, 0xdc, 0x98, 0x38,
+    0xb4, 0xcb, 0xf3, 0x93, 0x27, 0xb7, 0x07, 0x43, 0xb2, 0xff, 0x91, 0x07,
+    0x1d, 0x98, 0x34, 0xce, 0x96, 0x80, 0xbd, 0xd7, 0x6d, 0x9f, 0x84, 0x8b,
+    0x8e, 0x8b, 0x59, 0x0b, 0x89, 0xf6, 0xc2, 0x0c, 0x8a, 0xc1, 0xcf, 0x11,
+    0x2a, 0xce, 0x29, 0xb5, 0x07, 0x46, 0x11, 0x81, 0x40, 0x59, 0x0b, 0xc0,
+    0x46, 0xc0, 0x9b, 0x0a, 0xc8, 0x66, 0xac, 0xb1, 0xb0, 0x28, 0x21, 0x41
+  },
+  {
+    0xc0, 0x1a, 0x0c, 0xc8, 0x9d, 0xcc, 0x6d, 0xa6, 0x36, 0xa4, 0x38, 0x1b,
+    0xf4, 0x5c, 0xa0, 0x97, 0xc6, 0xd7, 0xdb, 0x95, 0xbe, 0xf3, 0xeb, 0xa7,
+    0xab, 0x7d, 0x7e, 0x8d, 0xf6, 0xb8, 0xa0, 0x7d, 0xa6, 0x75, 0x56, 0x38,
+    0x14, 0x20, 0x78, 0xef, 0xe8, 0xa9, 0xfd, 0xaa, 0x30, 0x9f, 0x64, 0xa2,
+    0xcb, 0xa8, 0xdf, 0x5c, 0x50, 0xeb, 0xd1, 0x4c, 0xb3, 0xc0, 0x4d, 0x1d,
+    0xba, 0x5a, 0x11, 0x46, 0x76, 0xda, 0xb5, 0xc3, 0x53, 0x19, 0x0f, 0xd4,
+    0x9b, 0x9e, 0x11, 0x21, 0x73, 0x6f, 0xac, 0x1d, 0x60, 0x59, 0xb2, 0xfe,
+    0x21, 0x60, 0xcc, 0x03, 0x4b, 0x4b, 0x67, 0x83, 0x7e, 0x88, 0x5f, 0x5a
+  },
+  {
+    0xf4, 0xc1, 0xa2, 0x0c, 0x18, 0x60, 0x8d, 0x0a, 0x40, 0xdf, 0x68, 0xcc,
+    0xdb, 0xb0, 0x5e, 0x81, 0x99, 0x4e, 0x2f, 0xb8, 0x47, 0x7a, 0xe6, 0xd7,
+    0xc0, 0x15, 0x7f, 0x60, 0x90, 0x28, 0xa0, 0x45, 0x84, 0xf1, 0x41, 0xfd,
+    0xd1, 0x66, 0xf3, 0xfe, 0x1e, 0xe1, 0xcf, 0x01, 0x11, 0x4a, 0x69, 0x8b,
+    0x4d, 0xa7, 0x50, 0x01, 0x5e, 0xe1, 0x39, 0x4b, 0xba, 0x51, 0xd3, 0x6a,
+    0x3d, 0xf0, 0x13, 0x40, 0xcc, 0x65, 0xe0, 0x6e, 0xdc, 0x82, 0x02, 0xbd,
+    0x46, 0xe6, 0x4a, 0x22, 0xfd, 0x94, 0xb9, 0x36, 0x74, 0xe8, 0xbc, 0xfe,
+    0xd8, 0x9a, 0x4e, 0x53, 0x4f, 0x6e, 0xf0, 0xd9, 0xc1, 0x55, 0x22, 0x48
+  },
+  {
+    0x00, 0xf8, 0xce, 0x71, 0xcf, 0xea, 0x03, 0x3c, 0xbb, 0xfe, 0x8a, 0xca,
+    0x44, 0x75, 0x36, 0x90, 0x77, 0xc4, 0x29, 0x6a, 0x28, 0xea, 0x3f, 0x38,
+    0x62, 0x54, 0x65, 0xbc, 0xb0, 0x93, 0x85, 0x4e, 0x8c, 0x63, 0xe5, 0xa3,
+    0x4a, 0x11, 0xde, 0x12, 0x0d, 0xf2, 0xc4, 0x29, 0xa9, 0x4a, 0x2a, 0xba,
+    0xa3, 0x13, 0x8b, 0x7b, 0x9d, 0xd2, 0xb0, 0x56, 0x44, 0x79, 0x9b, 0x7b,
+    0x49, 0x1a, 0xb9, 0x6b, 0x06, 0xd2, 0xe7, 0xc5, 0x46, 0xe6, 0x49, 0x2a,
+    0x45, 0xc4, 0x63, 0x92, 0xcd, 0xf9, 0x3e, 0xb1, 0x9e, 0x52, 0xab, 0xed,
+    0xe8, 0x6c, 0xab, 0x50, 0x9b, 0xe3, 0xeb, 0xb0, 0x79, 0x7d, 0xcf, 0x20
+  },
+  {
+    0x48, 0x5c, 0xe7, 0x8a, 0x4e, 0x8f, 0xd2, 0xcb, 0x60, 0x0b, 0x00, 0x44,
+    0x91, 0x02, 0xde, 0x3c, 0x70, 0x21, 0xbc, 0x98, 0xc8, 0xb9, 0x3b, 0x37,
+    0x86, 0x08, 0x57, 0x9f, 0x53, 0x88, 0x11, 0x7c, 0xca, 0x7d, 0xfe, 0xf0,
+    0x9d, 0x93, 0xb4, 0x7d, 0xce, 0x51, 0xa9, 0xcb, 0x0f, 0xb9, 0x0e, 0xf5,
+    0x1d, 0x1d, 0x7e, 0x35, 0x1c, 0xe6, 0x8b, 0x09, 0x9d, 0x46, 0x99, 0x88,
+    0x37, 0x62, 0x35, 0x02, 0x03, 0x4c, 0x5a, 0xe1, 0xfa, 0xef, 0xf6, 0x20,
+    0x05, 0x8e, 0x77, 0x3c, 0x94, 0x0a, 0x47, 0x2f, 0x67, 0xde, 0x99, 0xfc,
+    0x03, 0x0a, 0xf5, 0x79, 0x83, 0x14, 0x06, 0xd1, 0x88, 0x01, 0xd2, 0x38
+  },
+  {
+    0xdf, 0x15, 0x63, 0x0e, 0xad, 0x11, 0xe8, 0x23, 0x90, 0xb2, 0xae, 0xe2,
+    0x05, 0x0d, 0x65, 0x0b, 0x6c, 0x58, 0x5d, 0xa7, 0x59, 0x0f, 0xba, 0xb7,
+    0xee, 0x4d, 0x1f, 0x5e, 0xd4, 0xed, 0x3e, 0x04, 0x17, 0x32, 0x07, 0xc7,
+    0xf2, 0x47, 0xc1, 0xf6, 0x0c, 0xd2, 0xaf, 0xf3, 0x19, 0xb9, 0x51, 0xc6,
+    0x02, 0xf8, 0x41, 0x70, 0xfd, 0xdb, 0x8f, 0x25, 0x3e, 0x07, 0x45, 0x4f,
+    0xa9, 0x4f, 0x3c, 0x17, 0xc4, 0xf9, 0x8d, 0x92, 0x60, 0xea, 0x71, 0x3d,
+    0x2d, 0x56, 0x73, 0x33, 0x06, 0x78, 0x7e, 0x5b, 0xb2, 0x52, 0x95, 0xa2,
+    0x4c, 0x51, 0xb0, 0xd9, 0x72, 0xc4, 0x3c, 0x99, 0x24, 0x70, 0x2a, 0x1e
+  },
+  {
+    0x1f, 0x81, 0x5c, 0xd4, 0xbc, 0x0f, 0x1a, 0x60, 0x03, 0x08, 0xec, 0x92,
+    0x7d, 0xbc, 0xb7, 0x24, 0x7f, 0x40, 0xd2, 0x17, 0x2b, 0xe6, 0xca, 0xa0,
+    0x26, 0x5b, 0x22, 0x06, 0xee, 0x43, 0xcb, 0x5f, 0xa4, 0xfb, 0x09, 0x35,
+    0xb9, 0x09, 0x05, 0x31, 0x75, 0x1b, 0x63, 0x05, 0x76, 0xb3, 0x8d, 0x0d,
+    0x87, 0x1c, 0x40, 0x52, 0xba, 0xcc, 0xde, 0x97, 0x73, 0xe7, 0xb2, 0x11,
+    0xf4, 0x49, 0x46, 0x04, 0x5f, 0x21, 0x98, 0x95, 0xad, 0x24, 0x0d, 0x0c,
+    0x8c, 0x62, 0x36, 0xcc, 0x26, 0x90, 0x7f, 0x1b, 0xea, 0xdc, 0x16, 0x70,
+    0x55, 0x2f, 0x8e, 0x33, 0x8f, 0xe5, 0xc0, 0x5c, 0xfa, 0x1b, 0x8a, 0x0c
+  },
+  {
+    0x4c, 0x10, 0x1d, 0x68, 0xb5, 0x03, 0xe7, 0x8d, 0x45, 0xcb, 0x63, 0x12,
+    0x59, 0x7a, 0x2f, 0x3d, 0x63, 0x6c, 0xe5, 0x1c, 0x17, 0x0c, 0x71, 0xae,
+    0xca, 0xe6, 0xc3, 0xfc, 0x7e, 0x7c, 0x85, 0x6b, 0xc0, 0x01, 0x28, 0x8b,
+    0xb4, 0x56, 0xd2, 0x79, 0xc4, 0x0f, 0x40, 0x3c, 0xac, 0xbe, 0x9f, 0x7e,
+    0x41, 0xba, 0x33, 0x47, 0x1d, 0xab, 0x51, 0xa7, 0xca, 0x8a, 0x41, 0xdd,
+    0xf5, 0x2b, 0xde, 0x09, 0x7f, 0x68, 0xf0, 0xef, 0xf3, 0x0f, 0xf1, 0x3b,
+    0xa2, 0x7b, 0xe3, 0xf1, 0x34, 0xea, 0xba, 0x5e, 0x4d, 0x03, 0x66, 0x1d,
+    0x26, 0x61, 0x9e, 0xe4, 0xca, 0x42, 0xb2, 0xc3, 0x2a, 0x6e, 0x46, 0x5b
+  },
+  {
+    0x42, 0xb8, 0xfb, 0x47, 0x67, 0xeb, 0x7e, 0x13, 0x8b, 0x1a, 0x81, 0x60,
+    0x75, 0x5c, 0xdf, 0x79, 0x9a, 0xc8, 0xf8, 0x71, 0x6f, 0xa7, 0x2b, 0x5a,
+    0xc2, 0xff, 0xc8, 0x3b, 0x56, 0x2a, 0x95, 0x09, 0x3c, 0xf8, 0x7e, 0xdc,
+    0x4b, 0xcb, 0xa8, 0xa2, 0x26, 0xc2, 0x93, 0x5f, 0xfa, 0xc6, 0xb5, 0x96,
+    0xa5, 0xe3, 0x64, 0x06, 0x1b, 0xeb, 0xeb, 0xd4, 0x2f, 0xcf, 0xc6, 0xe5,
+    0xdc, 0x4a, 0x9b, 0x40, 0xc4, 0x50, 0x43, 0x83, 0xb9, 0x3d, 0xd5, 0x44,
+    0xb4, 0x05, 0xf5, 0xa5, 0x05, 0x93, 0x29, 0x89, 0x2f, 0xff, 0x49, 0x59,
+    0xa2, 0xfa, 0x22, 0xfb, 0x64, 0x7d, 0x65, 0x04, 0xa7, 0x68, 0xb9, 0x69
+  }
+};
+
+// group order L = 2^252 + 27742317777372353535851937790883648493
+static const uint8_t ed25519_l[32] = {
+  0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2,
+  0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10
+};
+
+// p = 2 * p (dbl-2008-hwcd, a = -1)
+static void
+ed25519_double (ed_point_t * p)
+{
+  bignum_t a, b, c;
+
+  x25519_sqr_n (&a, &p->X, 1);	// A = X^2
+  x25519_sqr_n (&b, &p->Y, 1);	// B = Y^2
+  x25519_sqr_n (&c, &p->Z, 1);
+  field_add (&c, &c);		// C = 2 * Z^2
+  field_add (&p->X, &p->Y);
+  x25519_sqr_n (&p->X, &p->X, 1);
+  field_sub (&p->X, &a);
+  field_sub (&p->X, &b);	// E = (X + Y)^2 - A - B
+  memset (&p->Y, 0, sizeof (bignum_t));
+  field_sub (&p->Y, &a);
+  field_sub (&p->Y, &b);	// H = - A - B
+  field_sub (&b, &a);		// G = B - A
+  memcpy (&a, &b, sizeof (bignum_t));
+  field_sub (&a, &c);		// F = G - C
+  x25519_mul (&p->T, &p->X, &p->Y);	// T = E * H
+  x25519_mul (&p->X, &p->X, &a);	// X = E * F
+  x25519_mul (&p->Y, &b, &p->Y);	// Y = G * H
+  x25519_mul (&p->Z, &a, &b);	// Z = F * G
+}
+
+// p = p + q, q in (y + x, y - x, 2dxy) form (madd-2008-hwcd-3)
+static void
+ed25519_add_niels (ed_point_t * p, bignum_t * q)
+{
+  bignum_t a, b, c;
+
+  memcpy (&a, &p->Y, sizeof (bignum_t));
+  field_sub (&a, &p->X);
+  x25519_mul (&a, &a, &q[1]);	// A = (Y - X) * (y - x)
+  memcpy (&b, &p->Y, sizeof (bignum_t));
+  field_add (&b, &p->X);
+  x25519_mul (&b, &b, &q[0]);	// B = (Y + X) * (y + x)
+  x25519_mul (&c, &p->T, &q[2]);	// C = T * 2dxy
+  field_add (&p->Z, &p->Z);	// D = 2 * Z
+  memcpy (&p->X, &b, sizeof (bignum_t));
+  field_sub (&p->X, &a);	// E = B - A
+  field_add (&b, &a);		// H = B + A
+  memcpy (&p->Y, &p->Z, sizeof (bignum_t));
+  field_add (&p->Y, &c);	// G = D + C
+  field_sub (&p->Z, &c);	// F = D - C
+  x25519_mul (&p->T, &p->X, &b);	// T = E * H
+  x25519_mul (&p->X, &p->X, &p->Z);	// X = E * F
+  x25519_mul (&p->Z, &p->Z, &p->Y);	// Z = F * G
+  x25519_mul (&p->Y, &p->Y, &b);	// Y = G * H
+}
+
+// result = encoded (k * B), k below 2^256
+static void
+ed25519_base_mul (uint8_t * result, bignum_t * k)
+{
+  ed_point_t p;
+  bignum_t q[3];
+  uint8_t i, j, n, idx, mask;
+
+  // neutral point (0, 1)
+  memset (&p, 0, sizeof (ed_point_t));
+  p.Y.value[0] = 1;
+  p.Z.value[0] = 1;
+
+  i = 64;
+  while (i--)
+    {
+      ed25519_double (&p);
+      idx = (k->value[i / 8] >> (i & 7)) & 1;
+      idx |= ((k->value[8 + i / 8] >> (i & 7)) & 1) << 1;
+      idx |= ((k->value[16 + i / 8] >> (i & 7)) & 1) << 2;
+      idx |= ((k->value[24 + i / 8] >> (i & 7)) & 1) << 3;
+
+      // constant time table lookup, for idx = 0 neutral point (1, 1, 0)
+      memset (q, 0, sizeof (q));
+      for (j = 1; j < 16; j++)
+	{
+	  mask = ((uint16_t) (j ^ idx) - 1) >> 8;
+	  for (n = 0; n < 96; n++)
+	    q[n / 32].value[n & 31] |= ed25519_comb[j - 1][n] & mask;
+	}
+      mask = ((uint16_t) idx - 1) >> 8;
+      q[0].value[0] |= 1 & mask;
+      q[1].value[0] |= 1 & mask;
+      ed25519_add_niels (&p, q);
+    }
+  // encode point, y with sign of x in bit 255
+  x25519_invert (&p.Z, &p.Z);
+  x25519_mul (&p.X, &p.X, &p.Z);
+  x25519_mul (&p.Y, &p.Y, &p.Z);
+  memcpy (result, &p.Y, 32);
+  result[31] |= (p.X.value[0] & 1) << 7;
+  memset (&p, 0, sizeof (ed_point_t));
+  memset (q, 0, sizeof (q));
+}
+
+// r = x mod L (x is 64 bytes)
+static void
+ed25519_mod_l (bignum_t * r, bigbignum_t * x)
+{
+  bignum_t l, t;
+  uint8_t i;
+
+  // mp_mod() needs modulus with highest bit set, reduce by 8 * L first
+  memset (&l, 0, sizeof (bignum_t));
+  memcpy (&l, ed25519_l, 32);
+  mp_shiftl2 (&l);
+  mp_shiftl (&l);
+  mp_mod (x, &l);
+  memset (r, 0, sizeof (bignum_t));
+  memcpy (r, x, 32);
+  // then subtract 4L, 2L, L (constant time)
+  for (i = 0; i < 3; i++)
+    {
+      mp_shiftr (&l);
+      x25519_cswap (r, &t, !mp_sub (&t, r, &l));
+    }
+}
+
+// hash seed, clamp scalar (in az[0..31]), az[32..63] is nonce prefix
+static void
+ed25519_expand (uint8_t * az, uint8_t * seed)
+{
+  sha512_ctx_t ctx;
+
+  sha512_init (&ctx);
+  sha512_update (&ctx, seed, 32);
+  sha512_final (&ctx, az);
+  az[0] &= 0xf8;
+  az[31] &= 0x7f;
+  az[31] |= 0x40;
+}
+
+// calculate public key (32 bytes, encoded point) from private key (seed)
+void
+ed25519_public_key (uint8_t * pub, uint8_t * seed)
+{
+  bignum_t p, a;
+  bignum_t *prev_prime;
+  uint8_t az[64];
+
+  DPRINT ("%s\n", __FUNCTION__);
+
+  prev_prime = x25519_field_init (&p);
+  ed25519_expand (az, seed);
+  memset (&a, 0, sizeof (bignum_t));
+  memcpy (&a, az, 32);
+  ed25519_base_mul (pub, &a);
+  field_prime = prev_prime;
+  memset (az, 0, sizeof (az));
+  memset (&a, 0, sizeof (bignum_t));
+}
+
+// generate private key (seed) and public key
+void
+ed25519_key_gener (uint8_t * pub, uint8_t * seed)
+{
+  rnd_get (seed, 32);
+  ed25519_public_key (pub, seed);
+}
+
+// sign message (len bytes), return 64 bytes signature (R || S) in sig
+void
+ed25519_sign (uint8_t * sig, uint8_t * message, uint16_t len, uint8_t * seed,
+	      uint8_t * pub)
+{
+  sha512_ctx_t ctx;
+  bignum_t p, a, r, k;
+  bignum_t *prev_prime;
+  bigbignum_t h;
+  uint8_t az[64];
+
+  DPRINT ("%s\n", __FUNCTION__);
+
+  prev_prime = x25519_field_init (&p);
+  ed25519_expand (az, seed);
+  memset (&a, 0, sizeof (bignum_t));
+  memcpy (&a, az, 32);
+
+  // r = SHA512 (prefix || M) mod L, R = r * B
+  memset (&h, 0, sizeof (bigbignum_t));
+  sha512_init (&ctx);
+  sha512_update (&ctx, az + 32, 32);
+  sha512_update (&ctx, message, len);
+  sha512_final (&ctx, h.value);
+  ed25519_mod_l (&r, &h);
+  ed25519_base_mul (sig, &r);
+  field_prime = prev_prime;
+
+  // k = SHA512 (R || A || M) mod L
+  sha512_init (&ctx);
+  sha512_update (&ctx, sig, 32);
+  sha512_update (&ctx, pub, 32);
+  sha512_update (&ctx, message, len);
+  sha512_final (&ctx, h.value);
+  ed25519_mod_l (&k, &h);
+
+  // S = r + k * a mod L
+  memset (&h, 0, sizeof (bigbignum_t));
+  mp_mul (&h, &k, &a);
+  ed25519_mod_l (&k, &h);
+  memset (&p, 0, sizeof (bignum_t));
+  memcpy (&p, ed25519_l, 32);
+  add_mod (&k, &r, &p);
+  memcpy (sig + 32, &k, 32);
+
+  memset (az, 0, sizeof (az));
+  memset (&a, 0, sizeof (bignum_t));
+  memset (&r, 0, sizeof (bignum_t));
+  memset (&h, 0, sizeof (bigbignum_t));
+}
+#endif
+
+#ifdef ECDSA_PRECOMPUTE
+/*
+Pool of precomputed ECDSA nonces (r, k^-1). Nonce does not depend on
+message or private key, only on curve. Pool is filled while card is idle
+(ecdsa_precompute() is called from card_poll()), and is consumed in
+ecdsa_sign(). Pool is in RAM only, it is cleared on card reset and on
+deauthentication. Curve parameters and generator are public and kept, pool
+is refilled for the same curve while card is idle.
+*/
+static struct
+{
+  struct ec_param ec;		// curve parameters, working_key is used as temp
+  ec_point_t g;
+  uint8_t count;
+  struct
+  {
+    bignum_t r;
+    bignum_t k_inv;
+  } item[ECDSA_PRECOMPUTE];
+} ecdsa_pool;
+
+void
+ecdsa_precompute_clear (void)
+{
+  // drop nonces only, curve parameters and generator are kept
+  memset (ecdsa_pool.item, 0, sizeof (ecdsa_pool.item));
+  ecdsa_pool.count = 0;
+}
+
+void
+ecdsa_precompute (void)
+{
+  ec_point_t R;
+  bignum_t *k = &(ecdsa_pool.ec.working_key);
+
+  // curve is not known yet, or pool is full
+  if (!ecdsa_pool.ec.mp_size)
+    return;
+  if (ecdsa_pool.count >= ECDSA_PRECOMPUTE)
+    return;
+
+  DPRINT ("%s %d\n", __FUNCTION__, ecdsa_pool.count);
+  memcpy (&R, &ecdsa_pool.g, sizeof (ec_point_t));
+  if (ec_key_gener (&R, &ecdsa_pool.ec))
+    return;
+  memcpy (&(ecdsa_pool.item[ecdsa_pool.count].r), &R.X, sizeof (bignum_t));
+  mp_inv_mod (&(ecdsa_pool.item[ecdsa_pool.count].k_inv), k,
+	      &ecdsa_pool.ec.order);
+  memset (k, 0, sizeof (bignum_t));
+  ecdsa_pool.count++;
+}
+
+// input: generator in R
+// return 0 and r in R->X, k^-1 in k or 1 if pool is empty
+static uint8_t
+ecdsa_precompute_get (ec_point_t * R, bignum_t * k, struct ec_param *ec)
+{
+  // new curve, (re)initialize pool
+  if (ecdsa_pool.ec.curve_type != ec->curve_type
+      || ecdsa_pool.ec.mp_size != ec->mp_size
+      || memcmp (&ecdsa_pool.ec.prime, &ec->prime, sizeof (bignum_t)))
+    {
+      ecdsa_precompute_clear ();
+      memcpy (&ecdsa_pool.ec, ec, sizeof (struct ec_param));
+      memset (&ecdsa_pool.ec.working_key, 0, sizeof (bignum_t));
+      memcpy (&ecdsa_pool.g, R, sizeof (ec_point_t));
+      return 1;
+    }
+  if (!ecdsa_pool.count)
+    return 1;
+  ecdsa_pool.count--;
+  DPRINT ("using precomputed nonce %d\n", ecdsa_pool.count);
+  memcpy (&R->X, &(ecdsa_pool.item[ecdsa_pool.count].r), sizeof (bignum_t));
+  memcpy (k, &(ecdsa_pool.item[ecdsa_pool.count].k_inv), sizeof (bignum_t));
+  memset (&(ecdsa_pool.item[ecdsa_pool.count]), 0,
+	  sizeof (ecdsa_pool.item[0]));
+  return 0;
+}
+#endif
+
 uint8_t
 ecdsa_sign (uint8_t * message, ecdsa_sig_t * ecsig, struct ec_param *ec)
 {
@@ -1268,9 +2678,16 @@ ecdsa_sign (uint8_t * message, ecdsa_sig_t * ecsig, struct ec_param *ec)
 
   for (i = 0; i < 5; i++)
     {
-      // generate key
-      if (ec_key_gener (R, ec))
-	continue;
+#ifdef ECDSA_PRECOMPUTE
+      // use precomputed r, k^-1 if available
+      if (ecdsa_precompute_get (R, k, ec))
+#endif
+	{
+	  // generate key
+	  if (ec_key_gener (R, ec))
+	    continue;
+	  mp_inv_mod (k, k, &ec->order);	// division by k
+	}
 // From generated temp public key only X coordinate is used
 // as "r" value of result. "s" value is calculated:
 
@@ -1282,7 +2699,6 @@ ecdsa_sign (uint8_t * message, ecdsa_sig_t * ecsig, struct ec_param *ec)
       mul_mod (&(R->Y), &(ecsig->priv_key), &(R->X), &ec->order);
       add_mod (&(R->Y), (bignum_t *) message, &ec->order);
 
-      mp_inv_mod (k, k, &ec->order);	// division by k
       mul_mod (&(R->Y), k, &(R->Y), &ec->order);
       if (!mp_is_zero (&(R->Y)))
 	return 0;
@@ -1291,6 +2707,133 @@ ecdsa_sign (uint8_t * message, ecdsa_sig_t * ecsig, struct ec_param *ec)
   return 1;
 }
 
+/*
+Sign "count" HASHes, all with same private key (ec->working_key).
+
+Nonce points are kept in projective representation, all Z coordinates are
+inverted by one mp_inv_mod() call (Montgomery's simultaneous inversion),
+nonces k are inverted in same way.  For each signature only 3 multiplications
+are needed instead of one inversion.
+
+Only X coordinate of nonce point is needed, Y is used to store partial
+products of Z, partial products of k are stored in Z.
+
+input:  generator point in ecsig[0].signature
+output: ecsig[i].R, ecsig[i].S
+*/
+uint8_t
+ecdsa_sign_batch (bignum_t * messages, ecdsa_sig_t * ecsig, uint8_t count,
+		  struct ec_param *ec)
+{
+  uint8_t i, j, *key;
+  ec_point_t g;
+  bignum_t acc, t;
+  ec_point_t *R;
+
+  DPRINT ("%s\n", __FUNCTION__);
+
+  memcpy (&g, &(ecsig[0].signature), sizeof (ec_point_t));
+  ec_set_param (ec);
+
+  for (j = 0; j < 5; j++)
+    {
+      // generate nonces k (in priv_key) and nonce points R = k * G
+      for (i = 0; i < count; i++)
+	{
+	  R = &(ecsig[i].signature);
+	  key = (uint8_t *) & (ecsig[i].priv_key);
+	  do
+	    {
+	      memset (key, 0, MP_BYTES);
+	      rnd_get (key, ec->mp_size);
+#if MP_BYTES >= 66
+	      if (ec->mp_size > 48)
+		key[65] &= 1;
+#endif
+	      memcpy (R, &g, sizeof (ec_point_t));
+	    }
+	  while (ec_mul_key (&(ecsig[i].priv_key), R, ec));
+	  // partial product of Z
+	  if (i)
+	    field_mul (&R->Y, &(ecsig[i - 1].signature.Y), &R->Z);
+	  else
+	    memcpy (&R->Y, &R->Z, sizeof (bignum_t));
+	}
+      R = &(ecsig[count - 1].signature);
+      if (mp_is_zero (&R->Y))
+	continue;
+      mp_inv_mod (&acc, &R->Y, &ec->prime);
+
+      // acc = (Z0 * .. * Zi)^-1,  t = Zi^-1
+      for (i = count - 1;; i--)
+	{
+	  R = &(ecsig[i].signature);
+	  if (i)
+	    {
+	      field_mul (&t, &acc, &(ecsig[i - 1].signature.Y));
+	      field_mul (&acc, &acc, &R->Z);
+	    }
+	  else
+	    memcpy (&t, &acc, sizeof (bignum_t));
+	  field_sqr (&t, &t);
+	  field_mul (&R->X, &R->X, &t);
+	  if (!i)
+	    break;
+	}
+      // From nonce point only X coordinate is used as "r" value
+      for (i = 0; i < count; i++)
+	{
+	  R = &(ecsig[i].signature);
+	  if (mp_is_zero (&R->X))
+	    break;
+	  if (mp_cmpGE (&R->X, &ec->order))
+	    break;
+	  // partial product of k
+	  if (i)
+	    mul_mod (&R->Z, &(ecsig[i - 1].signature.Z), &(ecsig[i].priv_key),
+		     &ec->order);
+	  else
+	    memcpy (&R->Z, &(ecsig[i].priv_key), sizeof (bignum_t));
+	}
+      if (i != count)
+	continue;
+      mp_inv_mod (&acc, &(ecsig[count - 1].signature.Z), &ec->order);
+
+      // s = (dA * r + e)/k  mod n
+      for (i = count - 1;; i--)
+	{
+	  R = &(ecsig[i].signature);
+	  if (i)
+	    {
+	      mul_mod (&t, &acc, &(ecsig[i - 1].signature.Z), &ec->order);
+	      mul_mod (&acc, &acc, &(ecsig[i].priv_key), &ec->order);
+	    }
+	  else
+	    memcpy (&t, &acc, sizeof (bignum_t));
+	  mul_mod (&R->Y, &(ec->working_key), &R->X, &ec->order);
+	  add_mod (&R->Y, &messages[i], &ec->order);
+	  mul_mod (&R->Y, &t, &R->Y, &ec->order);
+	  if (mp_is_zero (&R->Y))
+	    break;
+	  if (!i)
+	    break;
+	}
+      if (i)
+	continue;
+      if (mp_is_zero (&(ecsig[0].signature.Y)))
+	continue;
+      // clear nonces
+      for (i = 0; i < count; i++)
+	{
+	  memset (&(ecsig[i].signature.Z), 0, sizeof (bignum_t));
+	  memset (&(ecsig[i].priv_key), 0, sizeof (bignum_t));
+	}
+      memset (&acc, 0, sizeof (bignum_t));
+      memset (&t, 0, sizeof (bignum_t));
+      return 0;
+    }
+  return 1;
+}
 
 /***********************************************************************/
 //////////////////////////////////////////////////
@@ -89,5 +89,37 @@ uint8_t ec_key_gener (ec_point_t * pub_key,  struct ec_param *ec);
 // sign HASH in message, return R,S in ecdsa_sig_t, use parameters from ec_param
 uint8_t ecdsa_sign (uint8_t *message, ecdsa_sig_t * ecsig, struct ec_param *ec);
 
+// sign count HASHes (messages[]), return R,S in ecsig[], generator point in ecsig[0].signature
+uint8_t ecdsa_sign_batch (bignum_t * messages, ecdsa_sig_t * ecsig, uint8_t count, struct ec_param *ec);
+
 uint8_t ec_derive_key (ec_point_t * pub_key, struct ec_param *ec);
+
+// calculate pub_key->Y from pub_key->X and lowest bit of Y (SEC1 compressed point)
+uint8_t ec_point_decompress (ec_point_t * pub_key, uint8_t y_bit, struct ec_param *ec);
+
+#ifdef CURVE25519
+// X25519 (RFC 7748), all numbers 32 bytes, little endian
+uint8_t x25519 (bignum_t * result, bignum_t * scalar, bignum_t * u);
+
+// return generated private key in priv_key, public key in pub_key
+uint8_t x25519_key_gener (bignum_t * pub_key, bignum_t * priv_key);
+
+// Ed25519 (RFC 8032), seed = 32 bytes private key, pub = 32 bytes public key
+void ed25519_key_gener (uint8_t * pub, uint8_t * seed);
+
+// calculate public key from seed
+void ed25519_public_key (uint8_t * pub, uint8_t * seed);
+
+// return 64 bytes signature (R || S) of message in sig
+void ed25519_sign (uint8_t * sig, uint8_t * message, uint16_t len,
+		   uint8_t * seed, uint8_t * pub);
+#endif
+
+#ifdef ECDSA_PRECOMPUTE
+// precompute one ECDSA nonce (for curve used in last ecdsa_sign call)
+void ecdsa_precompute (void);
+
+// clear all precomputed nonces
+void ecdsa_precompute_clear (void);
+#endif
 #endif
@@ -0,0 +1,351 @@
+/*
+    ec_instance.h
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2026 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Template of curve specific point arithmetic, this file is included from
+    ec.c for each curve (no include guard!).  Parameters:
+
+    EC_NAME(x)     name of instance function (suffix for x)
+    EC_LEN         length of field element in bytes
+    EC_KEY_BYTES   length of scalar in bytes (without blinding)
+    EC_MUL(r,a,b)  multiplication (fixed length)
+    EC_SQR(r,a)    squaring (fixed length)
+    EC_RED(r,bn)   fast reduction
+    EC_A           0x40 for A=-3, 0x80 for A=0
+    EC_LAZY        1 = lazy reduction in field_add/field_sub (see below)
+
+    All parameters are undefined at end of this file.
+
+    Field elements and points are of type EC_NAME (fe_t) and EC_NAME
+    (point_t), EC_LEN bytes per coordinate, not MP_BYTES. EC_NAME (ec_mul)
+    converts from/to ec_point_t only at entry and exit. All called
+    bignum routines (EC_MUL, EC_SQR, EC_RED, mp_is_zero ..) must access
+    no more than EC_LEN bytes of a field element. The reduction depends on
+    mp_set_len() and field_prime (ec_set_param () must be called before
+    any function from this file is used).
+
+    Lazy reduction (EC_LAZY = 1, only for primes p > 2^(8 * EC_LEN - 1)):
+    field elements inside point arithmetic are only reduced below
+    2^(8 * EC_LEN), not below p. field_add/field_sub then need one pass (p
+    is subtracted or added only on carry/borrow), zero tests compare with 0
+    and p, and the result of ec_mul is reduced below p once at the end.
+    Fast reduction is not valid for any 2 * EC_LEN bytes input (for example
+    fast192reduction fails for 2^384 - 1), only for reachable products.  It
+    must be correct for products of two elements below 2^(8 * EC_LEN), up to
+    (2^(8 * EC_LEN) - 1)^2, which is slightly above p^2.
+*/
+
+#if EC_A != 0x40 && EC_A != 0x80
+#error unsupported value of A in curve instance
+#endif
+
+typedef struct
+{
+  uint8_t value[EC_LEN];
+} EC_NAME (fe_t);
+
+typedef struct
+{
+  EC_NAME (fe_t) X;
+  EC_NAME (fe_t) Y;
+  EC_NAME (fe_t) Z;
+} EC_NAME (point_t);
+
+#define FE		EC_NAME (fe_t)
+#define BN(x)		((bignum_t *) (x))
+
+static void
+EC_NAME (field_mul) (FE * r, FE * a, FE * b)
+{
+  EC_MUL (&bn_tmp, BN (a), BN (b));
+  EC_RED (BN (r), &bn_tmp);
+}
+
+static void
+EC_NAME (field_sqr) (FE * r, FE * a)
+{
+  EC_SQR (&bn_tmp, BN (a));
+  EC_RED (BN (r), &bn_tmp);
+}
+
+#if EC_LAZY
+// r = r + a, result below 2^(8 * EC_LEN)
+static void
+EC_NAME (field_add) (FE * r, FE * a)
+{
+  if (bn_add_v (r, a, EC_LEN, 0))
+    // r + a - p still above 2^(8 * EC_LEN) if no borrow
+    if (!bn_sub_v (r, r, field_prime, EC_LEN))
+      bn_sub_v (r, r, field_prime, EC_LEN);
+}
+
+// r = r - a, result below 2^(8 * EC_LEN)
+static void
+EC_NAME (field_sub) (FE * r, FE * a)
+{
+  if (bn_sub_v (r, r, a, EC_LEN))
+    // r - a + p still negative if no carry
+    if (!bn_add_v (r, field_prime, EC_LEN, 0))
+      bn_add_v (r, field_prime, EC_LEN, 0);
+}
+
+// r below p (r < 2^(8 * EC_LEN) < 2 * p)
+static void
+EC_NAME (field_canon) (FE * r)
+{
+  FE t;
+
+  if (!bn_sub_v (&t, r, field_prime, EC_LEN))
+    memcpy (r, &t, EC_LEN);
+}
+
+static uint8_t
+EC_NAME (field_is_zero) (FE * r)
+{
+  if (mp_is_zero (BN (r)))
+    return 1;
+  return !memcmp (r, field_prime, EC_LEN);
+}
+#else
+static void
+EC_NAME (field_add) (FE * r, FE * a)
+{
+  FE t;
+  uint8_t carry;
+
+  carry = bn_add_v (r, a, EC_LEN, 0);
+  carry |= bn_sub_v (&t, r, field_prime, EC_LEN) ^ 1;
+  if (carry)
+    memcpy (r, &t, EC_LEN);
+}
+
+static void
+EC_NAME (field_sub) (FE * r, FE * a)
+{
+  if (bn_sub_v (r, r, a, EC_LEN))
+    bn_add_v (r, field_prime, EC_LEN, 0);
+}
+
+#endif
+
+// reduce all coordinates below p
+static void
+EC_NAME (ec_point_canon) (EC_NAME (point_t) * a)
+{
+#if EC_LAZY
+  EC_NAME (field_canon) (&a->X);
+  EC_NAME (field_canon) (&a->Y);
+  EC_NAME (field_canon) (&a->Z);
+#else
+  (void) a;
+#endif
+}
+
+static void
+EC_NAME (ec_point_1_1_0) (EC_NAME (point_t) * a)
+{
+  memset (a, 0, sizeof (EC_NAME (point_t)));
+  a->X.value[0] = 1;
+  a->Y.value[0] = 1;
+}
+
+static void
+EC_NAME (ec_double) (EC_NAME (point_t) * a)
+{
+  FE M, YY, T;
+#if EC_A == 0x40
+  FE S;
+#endif
+
+  if (mp_is_zero (BN (&a->Z)))
+    return EC_NAME (ec_point_1_1_0) (a);
+
+  EC_NAME (field_sqr) (&YY, &a->Y);
+
+#if EC_A == 0x40
+  EC_NAME (field_sqr) (&S, &a->Z);
+  memcpy (&T, &S, EC_LEN);
+  EC_NAME (field_add) (&T, &a->X);
+
+  memcpy (&M, &a->X, EC_LEN);
+  EC_NAME (field_sub) (&M, &S);
+
+  EC_NAME (field_mul) (&M, &M, &T);	//M=3*(X-Z^2)*(X+X^2)
+#else
+  EC_NAME (field_sqr) (&M, &a->X);	// M = 3* X^2
+#endif
+  memcpy (&T, &M, EC_LEN);
+  EC_NAME (field_add) (&T, &T);
+  EC_NAME (field_add) (&M, &T);
+
+  EC_NAME (field_mul) (&a->Z, &a->Y, &a->Z);
+  EC_NAME (field_add) (&a->Z, &a->Z);	// Z = 2*Y*Z
+
+  EC_NAME (field_mul) (&a->Y, &a->X, &YY);	// S into Y
+  EC_NAME (field_add) (&a->Y, &a->Y);
+  EC_NAME (field_add) (&a->Y, &a->Y);	// S = 4*X*Y^2
+
+  EC_NAME (field_sqr) (&a->X, &M);	// X = M^2 - 2*S
+  EC_NAME (field_sub) (&a->X, &a->Y);	// -S
+  EC_NAME (field_sub) (&a->X, &a->Y);	// -S
+
+  EC_NAME (field_sqr) (&T, &YY);
+
+  EC_NAME (field_add) (&T, &T);
+  EC_NAME (field_add) (&T, &T);
+  EC_NAME (field_add) (&T, &T);
+
+  EC_NAME (field_sub) (&a->Y, &a->X);
+  EC_NAME (field_mul) (&a->Y, &M, &a->Y);
+  EC_NAME (field_sub) (&a->Y, &T);	//Y'=M*(S-X') - 8*Y^4
+}
+
+static void
+EC_NAME (ec_add) (EC_NAME (point_t) * a, EC_NAME (point_t) * b)
+{
+  FE u1, u2, s1, s2, t1, t2;
+
+  if (mp_is_zero (BN (&a->Z)))
+    {
+      memcpy (a, b, sizeof (EC_NAME (point_t)));
+      return;
+    }
+  if (mp_is_zero (BN (&b->Z)))
+    return;
+
+  EC_NAME (field_sqr) (&t1, &b->Z);
+  EC_NAME (field_mul) (&u1, &a->X, &t1);	//u1 = X1*Z2^2
+
+  EC_NAME (field_sqr) (&t2, &a->Z);
+  EC_NAME (field_mul) (&u2, &b->X, &t2);	//u2 = X2*Z1^2
+
+  EC_NAME (field_mul) (&t1, &t1, &b->Z);
+  EC_NAME (field_mul) (&s1, &a->Y, &t1);	//s1 = Y1*Z2^3
+
+  EC_NAME (field_mul) (&t2, &t2, &a->Z);
+  EC_NAME (field_mul) (&s2, &b->Y, &t2);	//s2 = Y2*Z1^3
+
+  EC_NAME (field_sub) (&u2, &u1);
+  EC_NAME (field_sub) (&s2, &s1);
+
+#if EC_LAZY
+  if (EC_NAME (field_is_zero) (&u2))
+    {
+      if (EC_NAME (field_is_zero) (&s2))
+#else
+  if (mp_is_zero (BN (&u2)))
+    {
+      if (mp_is_zero (BN (&s2)))
+#endif
+	return EC_NAME (ec_double) (a);
+      else
+	return EC_NAME (ec_point_1_1_0) (a);
+    }
+
+  EC_NAME (field_sqr) (&t1, &u2);	//t1 = H^2
+  EC_NAME (field_mul) (&t2, &u2, &t1);	//t2 = H^3
+  EC_NAME (field_mul) (&a->Y, &u1, &t1);	//t3 = u1*h^2
+
+  EC_NAME (field_sqr) (&a->X, &s2);
+  EC_NAME (field_sub) (&a->X, &t2);
+
+  EC_NAME (field_sub) (&a->X, &a->Y);
+  EC_NAME (field_sub) (&a->X, &a->Y);	//X3=R^2 - H^3 - 2*U1*H^2
+
+  EC_NAME (field_sub) (&a->Y, &a->X);
+  EC_NAME (field_mul) (&a->Y, &a->Y, &s2);
+
+  EC_NAME (field_mul) (&t1, &s1, &t2);
+  EC_NAME (field_sub) (&a->Y, &t1);
+
+  EC_NAME (field_mul) (&a->Z, &a->Z, &b->Z);
+  EC_NAME (field_mul) (&a->Z, &a->Z, &u2);
+}
+
+// ec_point_t <-> EC_NAME (point_t)
+static void
+EC_NAME (ec_point_load) (EC_NAME (point_t) * r, ec_point_t * p)
+{
+  memcpy (&r->X, &p->X, EC_LEN);
+  memcpy (&r->Y, &p->Y, EC_LEN);
+  memcpy (&r->Z, &p->Z, EC_LEN);
+}
+
+static void
+EC_NAME (ec_point_store) (ec_point_t * p, EC_NAME (point_t) * r)
+{
+  memset (p, 0, sizeof (ec_point_t));
+  memcpy (&p->X, &r->X, EC_LEN);
+  memcpy (&p->Y, &r->Y, EC_LEN);
+  memcpy (&p->Z, &r->Z, EC_LEN);
+}
+
+// same as ec_mul() with EC_MUL_WINDOW == 4
+static void
+EC_NAME (ec_mul) (ec_point_t * point, uint8_t * k)
+{
+  int8_t i;
+  uint8_t b, j;
+  uint8_t index;
+
+  EC_NAME (point_t) data[17];	// 0,1 used as result, 2..17 as precomputed table
+
+  EC_NAME (point_t) * r = &data[0];
+  EC_NAME (point_t) * table = &data[1];	// table 0 is not used .. but index is from 0
+
+  EC_NAME (ec_point_load) (&table[1], point);
+
+  for (index = 2; index < 16; index += 2)
+    {
+      memcpy (&table[index], &table[index / 2], sizeof (EC_NAME (point_t)));
+      EC_NAME (ec_double) (&table[index]);
+      memcpy (&table[index + 1], &table[index], sizeof (EC_NAME (point_t)));
+      EC_NAME (ec_add) (&table[index + 1], &table[1]);
+    }
+
+  memcpy (&r[1], &table[2], sizeof (EC_NAME (point_t)));
+  memset (&r[0], 0, sizeof (EC_NAME (point_t)));
+  for (i = EC_KEY_BYTES + EC_BLIND - 1; i >= 0; i--)
+    {
+      b = k[i];
+      for (j = 0; j < 2; j++)
+	{
+	  EC_NAME (ec_double) (&r[0]);
+	  EC_NAME (ec_double) (&r[0]);
+	  EC_NAME (ec_double) (&r[0]);
+	  EC_NAME (ec_double) (&r[0]);
+	  index = (b & 0xf0) == 0;
+	  EC_NAME (ec_add) (&r[index], &table[(b >> 4) | index]);
+	  b <<= 4;
+	}
+    }
+  EC_NAME (ec_point_canon) (&r[0]);
+  EC_NAME (ec_point_store) (point, &r[0]);
+}
+
+#undef FE
+#undef BN
+#undef EC_NAME
+#undef EC_LEN
+#undef EC_KEY_BYTES
+#undef EC_MUL
+#undef EC_SQR
+#undef EC_RED
+#undef EC_A
+#undef EC_LAZY
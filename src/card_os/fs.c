@@ -1475,6 +1475,72 @@ uint8_t fs_key_write_part(uint8_t * key)
 #undef K_SIZE
 }
 
+// check if generated EC key (private and public part, 'len' bytes with
+// TAG/LEN) can be written into selected key file by fs_key_write_parts()
+uint8_t fs_key_ec_generate_check(uint16_t len)
+{
+	uint16_t offset;
+
+	DPRINT("%s len=%d\n", __FUNCTION__, len);
+
+	if (check_EF_security(SEC_GENERATE))
+		return S0x6982;	//security status not satisfied
+	if (C_KEYp_FREE != fs_key_part(&offset, KEY_EC_PUBLIC))
+		return S0x6984;	//invalid data
+	if (C_KEYp_FREE != fs_key_part(&offset, KEY_EC_PRIVATE))
+		return S0x6984;	//invalid data
+	// parts are written to first free space in key file
+	if (offset - fci_sel.mem_offset + len > fci_sel.fs.size + 2)
+		return S0x6b00;	//outside EF
+	return S_RET_OK;
+}
+
+// write more generated key parts (concatenated type, size, value) into
+// empty space of selected key file with one device_write_block() call
+uint8_t fs_key_write_parts(uint8_t * parts, uint16_t len)
+{
+	uint16_t offset, pos;
+	uint16_t prop_flag = fci_sel.fs.prop | 0x200;	// "generated" flag
+
+	DPRINT("%s len=%d\n", __FUNCTION__, len);
+
+	if (len < 2)
+		return S0x6984;	//invalid data
+	if (check_EF_security(SEC_GENERATE))
+		return S0x6982;	//security status not satisfied
+
+	for (pos = 0; pos + 2 <= len; pos += parts[pos + 1] + 2) {
+		if (!(parts[pos] & KEY_GENERATE) || parts[pos + 1] == 0
+		    || parts[pos + 1] > 254)
+			return S0x6984;	//invalid data
+		parts[pos] &= (uint8_t) ~ KEY_GENERATE;
+		// allow only write to free space in key file
+		if (C_KEYp_FREE != fs_key_part(&offset, parts[pos])) {
+			DPRINT("key part 0x%02x already exists\n", parts[pos]);
+			return S0x6984;	//invalid data
+		}
+		if (parts[pos] == KEY_EC_PRIVATE || parts[pos] == KEY_RSA_MOD
+		    || parts[pos] == KEY_RSA_MOD_p2 || parts[pos] == KEY_AES_DES)
+			prop_flag |= 0x0100;	//mark as valid key file
+	}
+	if (pos != len)
+		return S0x6984;	//invalid data
+
+	// all parts are written to first free space in key file
+	if (offset - fci_sel.mem_offset + len > fci_sel.fs.size + 2)
+		return S0x6b00;	//outside EF
+
+	if (prop_flag != fci_sel.fs.prop) {
+		fci_sel.fs.prop = prop_flag;
+		if (device_write_block(&fci_sel.fs, fci_sel.mem_offset, sizeof(struct fs_data)))
+			return S0x6581;	//memory fail
+	}
+	if (1 == device_write_block(parts, offset, len))
+		return S0x6581;	//memory fail
+
+	return S_RET_OK;
+}
+
 static uint8_t fs_transparent_file(void)
 {
 	// do not test shareable file flag
@@ -1785,6 +1851,12 @@ uint8_t fs_create_file(uint8_t * buffer)
 			// allow only supported file types
 			if (type != 0x01 && type != 0x38 &&
 			    type != 0x11 && type != 0x22 && type != 0x23 &&
+#ifdef CURVE25519
+			    type != 0x24 && type != 0x25 &&
+#endif
+#ifdef CHACHA20_POLY1305
+			    type != 0x39 &&
+#endif
 			    type != 0x19 && type != 0x29)
 				return S0x6984;	//invalid data
 			flag |= 2;
@@ -1922,11 +1994,11 @@ uint8_t fs_list_files(uint8_t type, struct iso7816_response *r)
 	case 0xa4:		// all EF with RSA key
 		code = 0x11bf;
 		break;
-	case 0xa5:		// all EF with ECC key (0x22,0x23);
-		code = 0x22be;
+	case 0xa5:		// all EF with ECC key (0x22,0x23,0x24,0x25) - 20..27 (20,21 can not be created)
+		code = 0x20b8;
 		break;
 	case 0xa6:
-		code = 0x098f;	// 09 19 29 39 - only 29 an 19 are correct, but 09 and 39 can not be created
+		code = 0x098f;	// 09 19 29 39 - only 19, 29 (and 39 ChaCha20) are correct, 09 can not be created
 		break;
 	default:
 		return S0x6984;	//invalid data
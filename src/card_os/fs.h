@@ -60,6 +60,12 @@ uint16_t fs_key_read_part (uint8_t * key, uint8_t type);
 // 1st byte = key type, 2nd key part size, rest key part
 uint8_t fs_key_write_part (uint8_t * key);
 
+// more generated key parts (type with KEY_GENERATE, size, part) in one write
+uint8_t fs_key_write_parts (uint8_t * parts, uint16_t len);
+
+// check ACL and free space for generated EC key parts (total len bytes)
+uint8_t fs_key_ec_generate_check (uint16_t len);
+
 uint8_t fs_read_binary (uint16_t offset, struct iso7816_response *r);
 uint8_t fs_update_binary (uint8_t * buffer, uint16_t offset);
 
@@ -0,0 +1,84 @@
+/*
+    gcm.c
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    GHASH and counter helpers for AES-CTR/AES-GCM (NIST SP 800-38A/D)
+
+    Multiplication in GF(2^128) is the simple shift and add algorithm (SP
+    800-38D, algorithm 1), masks are used instead of branches, no tables.
+    Code is designed for small size, not for speed.
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "gcm.h"
+
+void
+gf128_mul_soft (uint8_t * x, uint8_t * h)
+{
+  uint8_t z[16], v[16];
+  uint8_t i, j, m, r;
+
+  memset (z, 0, 16);
+  memcpy (v, h, 16);
+  i = 0;
+  do
+    {
+      // bit 'i' of x (bit 0 = MSB of x[0])
+      m = -((x[i >> 3] >> (7 - (i & 7))) & 1);
+      for (j = 0; j < 16; j++)
+	z[j] ^= v[j] & m;
+      // v = v * x (right shift in GCM bit order)
+      r = -(v[15] & 1);
+      for (j = 15; j > 0; j--)
+	v[j] = (v[j] >> 1) | (v[j - 1] << 7);
+      v[0] = (v[0] >> 1) ^ (r & 0xe1);
+    }
+  while (++i < 128);
+  memcpy (x, z, 16);
+  memset (v, 0, 16);
+}
+
+void __attribute__ ((weak))
+gf128_mul (uint8_t * x, uint8_t * h)
+{
+  gf128_mul_soft (x, h);
+}
+
+void
+ghash_update (uint8_t * x, uint8_t * h, uint8_t * data, uint16_t len)
+{
+  uint8_t i;
+
+  while (len)
+    {
+      for (i = 0; i < 16 && len; i++, len--)
+	x[i] ^= *(data++);
+      gf128_mul (x, h);
+    }
+}
+
+void
+ctr_inc (uint8_t * ctr, uint8_t len)
+{
+  ctr += 16;
+  while (len--)
+    if (++(*(--ctr)))
+      break;
+}
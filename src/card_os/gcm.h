@@ -0,0 +1,40 @@
+/*
+    gcm.h
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    GHASH and counter helpers for AES-CTR/AES-GCM (NIST SP 800-38A/D)
+    header file
+
+*/
+#ifndef _GCM_H_
+#define _GCM_H_
+
+#define GCM_TAG_LEN 16
+
+// x = x * h in GF(2^128), GCM bit order (weak, target may override this)
+void gf128_mul (uint8_t * x, uint8_t * h);
+// generic (constant time) version
+void gf128_mul_soft (uint8_t * x, uint8_t * h);
+
+// x = GHASH_h(x, data), last incomplete block is padded by zeros
+void ghash_update (uint8_t * x, uint8_t * h, uint8_t * data, uint16_t len);
+
+// increment last 'len' bytes of 16 bytes counter block (big endian)
+void ctr_inc (uint8_t * ctr, uint8_t len);
+#endif
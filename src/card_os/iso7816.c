@@ -47,6 +47,9 @@ indent -linux -l100
 #include "fs.h"
 #include "myeid_emu.h"
 #include "card_io.h"
+#ifdef ECDSA_PRECOMPUTE
+#include "ec.h"
+#endif
 #ifdef CARD_TESTS
 #include "mem_device.h"
 #endif
@@ -125,10 +128,10 @@ static void return_status(uint8_t status)
 		// Na: exact number of available data bytes
 
 		// ISO77816 allow us to send fewer bytes as requested by Ne
-		// OsEID specific, return max 256 bytes, and signalize remaining bytes
+		// OsEID specific, return max APDU_NE_MAX bytes, and signalize remaining bytes
 		// if needed (for short/extended APDU)
-		if (Ne > 256)
-			Ne = 256;
+		if (Ne > APDU_NE_MAX)
+			Ne = APDU_NE_MAX;
 		if (Ne > Na) {
 #ifdef PROTOCOL_T0
 			if (iso_response.protocol == 0) {
@@ -157,7 +160,7 @@ static void return_status(uint8_t status)
 				message[Ne + 1] = Na;
 			else
 				message[Ne + 1] = 0;
-			memcpy(iso_response.data, iso_response.data + Ne, Na);
+			memmove(iso_response.data, iso_response.data + Ne, Na);
 		}
 		iso_response.len16 = Na;
 		DPRINT("sending response\n");
@@ -227,7 +230,7 @@ static uint8_t iso7816_verify(uint8_t * message, __attribute__((unused))
 
 static uint8_t iso7816_get_challenge(uint8_t * message, struct iso7816_response *r)
 {
-	uint8_t rlen;
+	uint16_t rlen, pos;
 
 	DPRINT("%s %02x %02x %02X\n", __FUNCTION__, M_P1, M_P2, M_P3);
 
@@ -235,11 +238,16 @@ static uint8_t iso7816_get_challenge(uint8_t * message, struct iso7816_response
 	if (M_P1 != 0 || M_P2 != 0)
 		return S0x6a86;	//incorrect P1,P2
 
-// Ne > 256 is handled in APDU parser  -> Ne = 256, in this case 0
-	rlen = r->Ne & 0xff;
-	if (rlen == 0)
-		return S0x6f00;	//no particular diagnostic (same response as from MyEID 3.3.3)
-	rnd_get(r->data, rlen);
+// short APDU Le = 0 (Ne = 256) is not allowed (same response as from MyEID 3.3.3),
+// extended Le is allowed, response is limited to APDU_NE_MAX
+	rlen = r->Ne;
+	if (rlen == 256 && !r->extended)
+		return S0x6f00;	//no particular diagnostic
+	if (rlen > APDU_NE_MAX)
+		rlen = APDU_NE_MAX;
+	// fill response buffer in 256 bytes blocks (rnd_get: size 0 = 256 bytes)
+	for (pos = 0; pos < rlen; pos += 256)
+		rnd_get(r->data + pos, (rlen - pos) > 255 ? 0 : rlen - pos);
 	r->len16 = rlen;
 	return S0x6100;
 }
@@ -434,6 +442,9 @@ static uint8_t deauthenticate(uint8_t * message, __attribute__((unused))
 	}
 
 	fs_deauth(pin);
+#ifdef ECDSA_PRECOMPUTE
+	ecdsa_precompute_clear();
+#endif
 	return S_RET_OK;
 }
 
@@ -497,7 +508,7 @@ static const struct f_table cla00[] = {
 	// ISO7816-8:2019(E)/5.2
 	{ATTR_T0_Le_present, 0x46, myeid_generate_key},
 	// ISO7816-4:2013(E)/11.3.5
-	{APDU_Ne | APDU_Lc_empty | ATTR_T0_P3NE, 0x84, iso7816_get_challenge},
+	{APDU_Ne | APDU_Lc_empty | ATTR_T0_P3NE | APDU_LONG, 0x84, iso7816_get_challenge},
 	// ISO7816-4:2013(E)/11.5.5
 	{ATTR_T0_Le_present | APDU_Nc, 0x86, myeid_ecdh_derive},
 	// ISO7816-4:2013(E)/11.1.1
@@ -526,6 +537,15 @@ static const struct f_table __flash cla80[] = {
 static const struct f_table cla80[] = {
 #endif
 	{APDU_Nc | ATTR_T0_Le_present | APDU_LONG, 0x2a, security_operation},	// iso7816-8....???
+#if ECDSA_BATCH_MAX > 0
+	{APDU_Nc | ATTR_T0_Le_present | APDU_LONG, 0x2c, myeid_ecdsa_sign_batch},	// proprietary ..
+#endif
+#if EC_KEYGEN_BATCH_MAX > 0
+	{APDU_Nc | ATTR_T0_Le_present, 0x46, myeid_generate_key_batch},	// proprietary ..
+#endif
+#ifdef ECIES
+	{APDU_Nc | ATTR_T0_Le_present | APDU_LONG, 0x86, myeid_ecies_decrypt},	// proprietary ..
+#endif
 	{APDU_Nc | APDU_Le_empty, 0xda, w_fs_key_change_type},	// proprietary ..
 	{0xff}
 };
@@ -601,6 +621,7 @@ static uint8_t parse_apdu(uint16_t input_len)
 	// defaults for Nc and Ne (CASE 1 APDU, T1 protocol)
 	Nc = 0;
 	Ne = 0;
+	r->extended = 0;
 #ifdef PROTOCOL_T1
 	if (input_len == 4) {
 		DPRINT("T1 CASE 1S\n");
@@ -672,6 +693,7 @@ static uint8_t parse_apdu(uint16_t input_len)
 				uint16_t LcExtended;
 
 				// extended cases 2E,3E,4E
+				r->extended = 1;
 				if (input_len < 7) {
 					DPRINT
 					    ("Protocol T1, extended case APDU, length below 7 (%d)\n",
@@ -919,6 +941,10 @@ void card_poll(void)
 {
 	uint16_t len;
 	for (;;) {
+#ifdef ECDSA_PRECOMPUTE
+		// card is idle, prepare one ECDSA nonce (if needed)
+		ecdsa_precompute();
+#endif
 		len = card_poll_();
 		DPRINT("protocol %d\n", iso_response.protocol);
 		if (len)
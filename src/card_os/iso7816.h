@@ -24,6 +24,14 @@
 #ifndef CS_ISO7816_H
 #define CS_ISO7816_H
 
+// APDU_LARGE - large buffers for extended APDU (Lc/Le up to APDU_LARGE
+// bytes, T1 protocol), for targets with enough RAM
+#ifdef APDU_LARGE
+#define APDU_CMD_LEN (APDU_LARGE + 9)
+#define APDU_RESP_LEN APDU_LARGE
+#define APDU_NE_MAX APDU_LARGE
+#endif
+
 // RSA 2048 need 256 bytes of data + padding indicator -> 257 bytes data part of APDU
 // 5 bytes header, max 257 bytes data +2+2 (to support Case 3E, 4E ISO786-3)
 #ifndef APDU_CMD_LEN
@@ -34,6 +42,10 @@
 #ifndef APDU_RESP_LEN
 #define APDU_RESP_LEN 258
 #endif
+// maximal number of data bytes in one response APDU (rest by GET RESPONSE)
+#ifndef APDU_NE_MAX
+#define APDU_NE_MAX 256
+#endif
 void card_poll (void);
 
 void response_clear (void);
@@ -43,6 +55,7 @@ struct iso7816_response
   uint8_t protocol;		// 0 T0 1 T1
   uint16_t Nc;			// 0, Lc not present, 1..65535 Lc
   uint16_t Ne;			// 0, Le not present, 1..65535 Le  (iso allow 65536 here, but for limited RAM in hardware this is not used)
+  uint8_t extended;		// 1 if extended Lc/Le is used in APDU (T1 only)
   uint8_t chaining_ins;
   uint8_t chaining_state;
   uint16_t len16;
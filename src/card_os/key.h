@@ -68,8 +68,11 @@
 #define RSA_KEY_EF	0x11
 #define EC1_KEY_EF	0x22
 #define EC2_KEY_EF	0x23
+#define X25519_KEY_EF	0x24
+#define ED25519_KEY_EF	0x25
 #define DES_KEY_EF	0x19
 #define AES_KEY_EF	0x29
+#define CHACHA_KEY_EF	0x39
 
 
 uint8_t get_rsa_key_part (void *here, uint8_t id);
@@ -56,6 +56,15 @@ indent -linux -l100
 #include "constants.h"
 #include "bn_lib.h"
 #include "mem_device.h"
+#ifdef ECIES
+#include "sha256.h"
+#endif
+#ifdef CHACHA20_POLY1305
+#include "chacha20.h"
+#endif
+#ifdef AES_CTR_GCM
+#include "gcm.h"
+#endif
 
 #define M_CLASS message[0]
 #define M_CMD message[1]
@@ -77,6 +86,36 @@ static uint8_t i_vector_tmp[I_VECTOR_MAX]
     __attribute__((section(".noinit")));
 static uint8_t i_vector[I_VECTOR_MAX] __attribute__((section(".noinit")));
 static uint8_t i_vector_len __attribute__((section(".noinit")));
+#ifdef AES_CTX
+// expanded AES key, valid for key file aes_ctx_uuid while APDU chain is running
+static aes_ctx_t aes_ctx;
+static uint16_t aes_ctx_uuid;
+#ifdef AES_NI
+// aes_ctx holds round keys for hardware AES
+static uint8_t aes_ctx_hw;
+#endif
+#endif
+#ifdef DES_CTX
+// DES/3DES key schedule, valid for key file des_ctx_uuid while APDU chain is running
+static des_ctx_t des_ctx;
+static uint16_t des_ctx_uuid;
+#endif
+#ifdef AES_CTR_GCM
+// reference algorithm (tag 0x80 in security environment), OsEID proprietary
+#define ALGO_AES_CTR 0x0c
+#define ALGO_AES_GCM 0x0d
+// GCM state, valid while APDU chain is running (counter is in i_vector_tmp)
+static struct {
+	uint8_t h[16];		// hash subkey
+	uint8_t x[16];		// GHASH accumulator
+	uint8_t j0[16];		// pre-counter block (for tag)
+	uint32_t len;		// ciphertext length in bytes
+} gcm_state;
+#endif
+#ifdef AES_CMAC
+// reference algorithm (tag 0x80 in security environment), OsEID proprietary
+#define ALGO_AES_CMAC 0x0e
+#endif
 
 // bits 0,1 = template in environment (depend on ISO7816-8, manage secutiry env, P2 (P2>>1)&3
 #define SENV_TEMPL_CT 0
@@ -149,6 +188,11 @@ static uint8_t check_ec_key_file(uint16_t size, uint8_t type)
 	if (type == EC2_KEY_EF)
 		if (size == 256)
 			return 0;
+#endif
+#ifdef CURVE25519
+	if (type == X25519_KEY_EF || type == ED25519_KEY_EF)
+		if (size == 255 || size == 256)
+			return 0;
 #endif
 	if (type == EC1_KEY_EF) {
 		if (size == 192)
@@ -318,6 +362,19 @@ static uint16_t rsa_raw(uint16_t len, uint8_t * message, uint8_t * result, uint8
 	return part_size | 0x8000;
 }
 
+#ifdef EC_PARAM_CACHE
+// decoded parameters of last used curve (same layout as struct ec_param up
+// to curve_type, generator in g)
+static struct {
+	bignum_t prime;
+	bignum_t order;
+	bignum_t a;
+	bignum_t b;
+	uint8_t curve_type;
+	ec_point_t g;
+} ec_param_cache;
+#endif
+
 // for NIST curves and for secp256k1 A is not needed
 // Special values of A (A=0, A=-3) are indicated in the c->curve_type
 // (A and B is needed for ECDH operation to check if point is on curve)
@@ -345,6 +402,11 @@ static uint8_t prepare_ec_param(struct ec_param *c, ec_point_t * p, uint8_t size
 	} else
 		ret = size;
 
+#ifdef CURVE25519
+	// X25519/Ed25519 key is not usable for ECDSA/ECDH on Weierstrass curves
+	if ((fs_get_file_type() & 0xfe) == X25519_KEY_EF)
+		return 0;
+#endif
 #ifndef NIST_ONLY
 	if (fs_get_file_type() == EC2_KEY_EF) {
 		var_C = C_SECP256K1 | C_SECP256K1_MASK;
@@ -373,6 +435,23 @@ static uint8_t prepare_ec_param(struct ec_param *c, ec_point_t * p, uint8_t size
 			return 0;
 	}
 	c->curve_type = var_C;
+#ifdef EC_PARAM_CACHE
+	if (ec_param_cache.curve_type != var_C) {
+		memset(&ec_param_cache, 0, sizeof(ec_param_cache));
+		var_C &= 0x3f;
+		get_constant((uint8_t *) & (ec_param_cache.g.X), var_C + 5);
+		get_constant((uint8_t *) & (ec_param_cache.g.Y), var_C + 6);
+		get_constant(&ec_param_cache.prime, var_C + 1);
+		get_constant(&ec_param_cache.order, var_C + 2);
+		get_constant(&ec_param_cache.a, var_C + 3);
+		get_constant(&ec_param_cache.b, var_C + 4);
+		ec_param_cache.curve_type = c->curve_type;
+	}
+	if (p)
+		memcpy(p, &ec_param_cache.g, sizeof(ec_point_t));
+	// prime, order, a, b
+	memcpy(c, &ec_param_cache, 4 * sizeof(bignum_t));
+#else
 	var_C &= 0x3f;
 	if (p) {
 		memset(p, 0, sizeof(ec_point_t));
@@ -383,6 +462,7 @@ static uint8_t prepare_ec_param(struct ec_param *c, ec_point_t * p, uint8_t size
 	get_constant(&c->order, var_C + 2);
 	get_constant(&c->a, var_C + 3);
 	get_constant(&c->b, var_C + 4);
+#endif
 
 	reverse_string((uint8_t *) & c->working_key, ret);
 	c->mp_size = ret;
@@ -407,6 +487,44 @@ static uint8_t add_num_to_seq(uint8_t * here, uint8_t * num, uint8_t size)
 	return ret + 2;
 }
 
+// Generate object 1.2.840.10045.4.1  with r and s value, return length of object
+static uint8_t ec_sig_to_der(uint8_t * der, ecdsa_sig_t * e, uint8_t size)
+{
+	uint8_t *here;
+	uint8_t skip, skip0;
+
+	DPRINT("size=%d\n", size);
+
+// sequence 0x30, LEN, 0x02, R, 0x02, S
+// there is simplification for calculating LEN that generates invalid DER (valid BER) for 61 bytes R/S value:
+
+// 0x30, LEN      , 2  ,R[61],2,  S[61]  = 126
+// 0x30, LEN      , 2,0,R[61],2,  S[61]  = 127
+// 0x30, LEN      , 2,0,R[61],2,0,S[61]  = 127
+// 0x30, 0x81,LEN , 2,0,R[61],2,0,S[61]  = 129
+
+// for LEN = 126 / 127  LEN is coded as 0x81 0x7e / 0x81 0x7f correct coding is 0x7e / 0x7f
+// This simplification is no problem for OsEID, here only  24,32,48, or 66 bytes are used
+
+	der[0] = 0x30;
+	skip0 = 2;
+
+#if MP_BYTES > 60
+	if (size > 60) {
+		der[1] = 0x81;
+		skip0 = 3;
+	}
+#endif
+	here = der + skip0;
+	skip = add_num_to_seq(here, e->R.value, size);
+	here += skip;
+	skip += add_num_to_seq(here, e->S.value, size);
+
+	der[skip0 - 1] = skip;
+
+	return skip + skip0;
+}
+
 // return error code if fail, or response if ok
 static uint8_t sign_ec_raw(uint8_t * message, struct iso7816_response *r, uint16_t size)
 {
@@ -459,43 +577,90 @@ static uint8_t sign_ec_raw(uint8_t * message, struct iso7816_response *r, uint16
 	HPRINT("SIGNATURE R:\n", e->R.value, ret);
 	HPRINT("SIGNATURE S:\n", e->S.value, ret);
 
-// Generate object 1.2.840.10045.4.1  with r and s value
+	RESP_READY(ec_sig_to_der(r->data, e, c->mp_size));
+}
 
-	uint8_t *here;
-	uint8_t skip, skip0;
+#ifdef CURVE25519
+// Ed25519 sign, message is not hashed before (PureEdDSA)
+static uint8_t sign_ed25519(uint8_t * message, struct iso7816_response *r, uint16_t size)
+{
+	uint8_t key[64];
 
-	DPRINT("size=%d\n", c->mp_size);
+	DPRINT("%s\n", __FUNCTION__);
 
-// sequence 0x30, LEN, 0x02, R, 0x02, S
-// there is simplification for calculating LEN that generates invalid DER (valid BER) for 61 bytes R/S value:
+	if (32 != fs_key_read_part(NULL, KEY_EC_PRIVATE))
+		return S0x6985;	//    Conditions not satisfied
+	fs_key_read_part(key, KEY_EC_PRIVATE);
+	// public key is part of hashed data, calculate it if not present in file
+	if (32 != fs_key_read_part(NULL, KEY_EC_PUBLIC))
+		ed25519_public_key(key + 32, key);
+	else
+		fs_key_read_part(key + 32, KEY_EC_PUBLIC);
 
-// 0x30, LEN      , 2  ,R[61],2,  S[61]  = 126
-// 0x30, LEN      , 2,0,R[61],2,  S[61]  = 127
-// 0x30, LEN      , 2,0,R[61],2,0,S[61]  = 127
-// 0x30, 0x81,LEN , 2,0,R[61],2,0,S[61]  = 129
+	card_io_start_null();
+	ed25519_sign(r->data, message, size, key, key + 32);
+	memset(key, 0, sizeof(key));
+	RESP_READY(64);
+}
+#endif
 
-// for LEN = 126 / 127  LEN is coded as 0x81 0x7e / 0x81 0x7f correct coding is 0x7e / 0x7f
-// This simplification is no problem for OsEID, here only  24,32,48, or 66 bytes are used
+#if ECDSA_BATCH_MAX > 0
+// return error code if fail, or response if ok
+static uint8_t sign_ec_batch(uint8_t * message, struct iso7816_response *r, uint16_t size)
+{
+	struct ec_param *c = alloca(sizeof(struct ec_param));
+	ec_point_t *g = alloca(sizeof(ec_point_t));
+	ecdsa_sig_t *e;
+	bignum_t *m;
+	uint8_t ret, count, i;
+	uint16_t len;
 
-	r->data[0] = 0x30;
-	skip0 = 2;
+	DPRINT("%s\n", __FUNCTION__);
 
-#if MP_BYTES > 60
-	if (c->mp_size > 60) {
-		r->data[1] = 0x81;
-		skip0 = 3;
+	ret = prepare_ec_param(c, g, 0);
+	if (ret == 0) {
+		DPRINT("Error, unable to get EC parameters/key\n");
+		return S0x6985;
 	}
+	// all HASHes must be padded to key size
+	if (size % ret)
+		return S0x6700;	// Incorrect length
+	count = size / ret;
+	if (count > ECDSA_BATCH_MAX)
+		return S0x6700;	// Incorrect length
+
+	// check if all signatures fit into response buffer
+	len = 2 + 2 * (3 + ret);
+#if MP_BYTES > 60
+	if (ret > 60)
+		len++;
 #endif
-	here = r->data + skip0;
-	skip = add_num_to_seq(here, e->R.value, c->mp_size);
-	here += skip;
-	skip += add_num_to_seq(here, e->S.value, c->mp_size);
+	if (count * len > APDU_RESP_LEN)
+		return S0x6700;	// Incorrect length
+
+	e = alloca(count * sizeof(ecdsa_sig_t));
+	m = alloca(count * sizeof(bignum_t));
+	memcpy(&e[0].signature, g, sizeof(ec_point_t));
 
-	r->data[skip0 - 1] = skip;
+	// messages to numbers
+	memset(m, 0, count * sizeof(bignum_t));
+	for (i = 0; i < count; i++)
+		reverse_copy((uint8_t *) & m[i], message + i * ret, ret);
 
-	skip += skip0;
-	RESP_READY(skip);
+	// this is  long operation, start sending NULL
+	card_io_start_null();
+
+	DPRINT("SIGN %d messages...\n", count);
+	if (ecdsa_sign_batch(m, e, count, c)) {
+		DPRINT("SIGN FAIL\n");
+		return S0x6985;
+	}
+	for (len = 0, i = 0; i < count; i++)
+		len += ec_sig_to_der(r->data + len, &e[i], ret);
+
+	RESP_READY(len);
 }
+#endif
 
 uint8_t security_env_set_reset(uint8_t * message, __attribute__((unused))
 			       struct iso7816_response *r)
@@ -682,6 +847,13 @@ AES/DES  tag 0x80, value 0x80 - pkcs#7 padding
 			case 0x0A:	// WRAP/UNWRAP
 			case 0x80:	// remove/add PKCS#7 padding
 			case 0x8A:	// WRAP/UNWRAP (PKCS#7 padding)
+#ifdef AES_CTR_GCM
+			case ALGO_AES_CTR:
+			case ALGO_AES_GCM:
+#endif
+#ifdef AES_CMAC
+			case ALGO_AES_CMAC:
+#endif
 				break;
 			default:
 				return S0x6a81;	//Function not supported // change to wrong arg ?
@@ -772,6 +944,10 @@ static uint8_t security_operation_rsa_ec_sign(struct iso7816_response *r)
 	}
 // SIGN operation posible values for reference algo: 0,2,4,0x12
 	if (sec_env_reference_algo == 4) {
+#ifdef CURVE25519
+		if (fs_get_file_type() == ED25519_KEY_EF)
+			return sign_ed25519(r->input + 5, r, size);
+#endif
 		DPRINT("RAW-ECDSA-PKCS algo %02x\n", sec_env_reference_algo);
 		// in buffer RAW data to be signed
 		return sign_ec_raw(r->input + 5, r, size);
@@ -812,6 +988,215 @@ static void apply_iv(uint8_t * data)
 		data[i] ^= i_vector_tmp[i];
 }
 
+#if defined (AES_CTR_GCM) || defined (AES_CMAC)
+#ifdef AES_CTX
+// expand key into aes_ctx (for hardware AES if available)
+static void aes_ctx_setup(uint8_t * key, uint8_t ksize)
+{
+#ifdef AES_NI
+	aes_ctx_hw = aes_ctx_hw_init(&aes_ctx, key, ksize);
+	if (aes_ctx_hw)
+		return;
+#endif
+	aes_ctx_init(&aes_ctx, key, ksize);
+}
+#endif
+
+// ECB encipher, len must be multiple of 16
+static void aes_ecb_encrypt(uint8_t * p, uint16_t len, uint8_t * key, uint8_t ksize)
+{
+#ifdef AES_CTX
+	// key is already expanded in aes_ctx
+	(void)key;
+	(void)ksize;
+#ifdef AES_NI
+	if (aes_ctx_hw) {
+		aes_cbc_hw_ctx(&aes_ctx, p, len, NULL, 0);
+		return;
+	}
+#endif
+#elif defined (AES_NI)
+	if (aes_cbc_hw(p, len, key, ksize, NULL, 0))
+		return;
+#endif
+	for (; len; len -= 16, p += 16)
+#ifdef AES_CTX
+		aes_ctx_run(&aes_ctx, p, 0);
+#else
+		aes_run(p, key, ksize, 0);
+#endif
+}
+#endif
+
+#ifdef AES_CTR_GCM
+// GCM length block (no additional data, only length of IV or ciphertext)
+static void gcm_len_block(uint8_t * b, uint32_t len)
+{
+	uint8_t i;
+
+	memset(b, 0, 16);
+	b[15] = len << 3;
+	len >>= 5;
+	for (i = 14; i > 10; i--) {
+		b[i] = len;
+		len >>= 8;
+	}
+}
+
+static void gcm_tag(uint8_t * tag, uint8_t * key, uint8_t ksize)
+{
+	uint8_t i;
+
+	gcm_len_block(tag, gcm_state.len);
+	ghash_update(gcm_state.x, gcm_state.h, tag, 16);
+	memcpy(tag, gcm_state.j0, 16);
+	aes_ecb_encrypt(tag, 16, key, ksize);
+	for (i = 0; i < 16; i++)
+		tag[i] ^= gcm_state.x[i];
+}
+
+/*!
+  @brief run AES in CTR or GCM mode (NIST SP 800-38A, SP 800-38D)
+
+  CTR: initial counter block is taken from initialization vector (16
+  bytes), whole counter block is incremented (big endian).
+
+  GCM: IV is taken from initialization vector (any size, 12 bytes
+  recommended), additional authenticated data is not supported, tag is 16
+  bytes.  Encipher returns ciphertext, last APDU of chain returns
+  ciphertext followed by tag.  Decipher collects whole chain (ciphertext and
+  tag), plaintext is returned only if tag is correct.
+
+  Counter (and GHASH state) is carried over chained APDUs, all APDUs except
+  last APDU of chain must contain multiple of 16 bytes.
+
+  IV is invalidated after encipher (last APDU of chain), new IV must be
+  set by MSE before next encipher.
+
+  @param[in]  r->data		data to be encoded
+  @param[out] r->data		encoded result
+  @param[in]  r->Nc		size
+  @param[in]  mode   		0 = encipher, any other value decipher
+  @param[in]  key		AES key
+  @param[in]  ksize		key size
+
+  @return SW code
+  @retval S0x6700 - wrong length
+  @retval S0x6985 - conditions not satisfied - no IV, wrong tag
+  @retval S0x6981 - incorect file type - wrong key size
+ */
+static uint8_t aes_ctr_gcm_cipher(struct iso7816_response *r, uint8_t mode, uint8_t * key,
+				  uint8_t ksize)
+{
+	uint8_t ks[64];
+	uint8_t *p = r->data;
+	uint16_t size = r->Nc;
+	uint16_t offset;
+	uint8_t gcm, first, i, n;
+	uint8_t ret = S_RET_OK;
+
+	gcm = sec_env_reference_algo == ALGO_AES_GCM;
+	DPRINT("%s %s mode %s chain state %d\n", __FUNCTION__, gcm ? "GCM" : "CTR",
+	       mode ? "decipher" : "encipher", r->chaining_state);
+
+	if (gcm && mode) {
+		// Wait for full APDU (tag is checked before decipher)
+		if (r->chaining_state & APDU_CHAIN_RUNNING) {
+			DPRINT("APDU chaining is active, waiting more data\n");
+			return S_RET_OK;
+		}
+		if (size < GCM_TAG_LEN)
+			return S0x6700;	//Incorrect length
+		size -= GCM_TAG_LEN;
+	}
+	if (r->chaining_state & APDU_CHAIN_RUNNING) {
+		// only last APDU in chain can hold incomplete block
+		if (size & 15)
+			return S0x6700;	//Incorrect length
+	} else if (gcm && !mode && size + GCM_TAG_LEN > APDU_RESP_LEN)
+		return S0x6700;	//Incorrect length
+
+	if (!(sec_env_valid & SENV_INIT_VECTOR) || !i_vector_len || (!gcm && i_vector_len != 16))
+		return S0x6985;	//    Conditions not satisfied
+
+	if (ksize != 16 && ksize != 24 && ksize != 32)
+		return S0x6981;	//incorect file type
+
+	first = r->chaining_state <= APDU_CHAIN_START || (gcm && mode);
+#ifdef AES_CTX
+	if (first || aes_ctx_uuid != fs_get_selected_uuid()) {
+		aes_ctx_setup(key, ksize);
+		aes_ctx_uuid = fs_get_selected_uuid();
+	}
+#endif
+	if (first) {
+		memcpy(i_vector_tmp, i_vector, i_vector_len);
+		if (gcm) {
+			memset(&gcm_state, 0, sizeof(gcm_state));
+			aes_ecb_encrypt(gcm_state.h, 16, key, ksize);
+			if (i_vector_len == 12) {
+				memcpy(gcm_state.j0, i_vector, 12);
+				gcm_state.j0[15] = 1;
+			} else {
+				gcm_len_block(ks, i_vector_len);
+				ghash_update(gcm_state.j0, gcm_state.h, i_vector, i_vector_len);
+				ghash_update(gcm_state.j0, gcm_state.h, ks, 16);
+			}
+			memcpy(i_vector_tmp, gcm_state.j0, 16);
+			ctr_inc(i_vector_tmp, 4);
+		}
+	}
+	if (gcm) {
+		gcm_state.len += size;
+		if (mode) {
+			ghash_update(gcm_state.x, gcm_state.h, p, size);
+			gcm_tag(ks, key, ksize);
+			for (n = 0, i = 0; i < GCM_TAG_LEN; i++)
+				n |= ks[i] ^ p[size + i];
+			if (n) {
+				DPRINT("tag check fail\n");
+				ret = S0x6985;	//    Conditions not satisfied
+				goto clear;
+			}
+		}
+	}
+	for (offset = 0; offset < size; offset += n) {
+		n = size - offset > 64 ? 64 : size - offset;
+		// counter blocks, then key stream (blocks are independent)
+		for (i = 0; i < n; i += 16) {
+			memcpy(ks + i, i_vector_tmp, 16);
+			ctr_inc(i_vector_tmp, gcm ? 4 : 16);
+		}
+		aes_ecb_encrypt(ks, i, key, ksize);
+		for (i = 0; i < n; i++)
+			p[offset + i] ^= ks[i];
+	}
+	if (gcm && !mode) {
+		ghash_update(gcm_state.x, gcm_state.h, p, size);
+		if (!(r->chaining_state & APDU_CHAIN_RUNNING)) {
+			gcm_tag(p + size, key, ksize);
+			size += GCM_TAG_LEN;
+		}
+	}
+ clear:
+	memset(ks, 0, sizeof(ks));
+	if (!(r->chaining_state & APDU_CHAIN_RUNNING)) {
+		memset(&gcm_state, 0, sizeof(gcm_state));
+#ifdef AES_CTX
+		memset(&aes_ctx, 0, sizeof(aes_ctx));
+#endif
+		// do not allow reuse of counter/nonce for next encipher
+		if (!mode) {
+			sec_env_valid &= ~SENV_INIT_VECTOR;
+			i_vector_len = 0;
+		}
+	}
+	if (ret)
+		return ret;
+	RESP_READY(size);
+}
+#endif
+
 /*!
   @brief run AES or DES in CBC mode
 
@@ -886,6 +1271,13 @@ static uint8_t des_aes_cipher(struct iso7816_response *r, uint8_t mode)
 
 	type = fs_get_file_type();
 	DPRINT("key type =%02x size=%d\n", type, size);
+#ifdef AES_CTR_GCM
+	if (sec_env_reference_algo == ALGO_AES_CTR || sec_env_reference_algo == ALGO_AES_GCM) {
+		if (type != AES_KEY_EF)
+			return S0x6981;	//incorect file type
+		return aes_ctr_gcm_cipher(r, mode, data, ksize);
+	}
+#endif
 	if (type == DES_KEY_EF) {
 		bsize = 8;
 
@@ -942,16 +1334,49 @@ static uint8_t des_aes_cipher(struct iso7816_response *r, uint8_t mode)
 	if (padd_len)
 		return S0x6700;	//Incorrect length
 
-	for (offset = size; offset; offset -= bsize, p += bsize) {
+	offset = size;
+#ifdef AES_NI
+	// whole CBC/ECB operation by hardware (if available)
+	if (type == AES_KEY_EF && (i_vector_len == 16 || i_vector_len == 0)
+	    && aes_cbc_hw(p, size, data, ksize, i_vector_len ? i_vector_tmp : NULL, mode)) {
+		p += size;
+		offset = 0;
+	}
+#endif
+#ifdef AES_CTX
+	// expand key once per APDU chain
+	if (offset && type == AES_KEY_EF && (r->chaining_state <= APDU_CHAIN_START
+					     || aes_ctx_uuid != fs_get_selected_uuid())) {
+		aes_ctx_init(&aes_ctx, data, ksize);
+		aes_ctx_uuid = fs_get_selected_uuid();
+	}
+#endif
+#ifdef DES_CTX
+	// key schedule once per APDU chain
+	if (offset && type == DES_KEY_EF && (r->chaining_state <= APDU_CHAIN_START
+					     || des_ctx_uuid != fs_get_selected_uuid())) {
+		des_ctx_init(&des_ctx, data, flag);
+		des_ctx_uuid = fs_get_selected_uuid();
+	}
+#endif
+	for (; offset; offset -= bsize, p += bsize) {
 		if (mode == 0)
 			apply_iv(p);
 		else
 			memcpy(iv, p, bsize);
 
 		if (type == AES_KEY_EF)
+#ifdef AES_CTX
+			aes_ctx_run(&aes_ctx, p, mode);
+#else
 			aes_run(p, data, ksize, mode);
+#endif
 		else
+#ifdef DES_CTX
+			des_ctx_run(&des_ctx, p);
+#else
 			des_run(p, data, flag);
+#endif
 
 		if (mode == 0)
 			memcpy(i_vector_tmp, p, bsize);
@@ -960,6 +1385,15 @@ static uint8_t des_aes_cipher(struct iso7816_response *r, uint8_t mode)
 			memcpy(i_vector_tmp, iv, bsize);
 		}
 	}
+#ifdef AES_CTX
+	// clear expanded key at end of APDU chain
+	if (type == AES_KEY_EF && !(r->chaining_state & APDU_CHAIN_RUNNING))
+		memset(&aes_ctx, 0, sizeof(aes_ctx));
+#endif
+#ifdef DES_CTX
+	if (type == DES_KEY_EF && !(r->chaining_state & APDU_CHAIN_RUNNING))
+		memset(&des_ctx, 0, sizeof(des_ctx));
+#endif
 
 // pkcs#7 padding remove
 	if (mode != 0 && last_block_padding) {
@@ -979,6 +1413,65 @@ static uint8_t des_aes_cipher(struct iso7816_response *r, uint8_t mode)
 	RESP_READY(size);
 }
 
+#ifdef CHACHA20_POLY1305
+/*!
+  @brief run ChaCha20-Poly1305 AEAD (RFC 8439, no additional data)
+
+  Nonce (12 bytes) is taken from initialization vector (tag 0x87 in sec.
+  env.), whole chain of APDUs is collected first.  Nonce is invalidated
+  after encipher, new nonce must be set by MSE before next encipher.
+
+  @param[in]  r->data		plaintext (encipher) or ciphertext and tag (decipher)
+  @param[out] r->data		ciphertext and tag (encipher) or plaintext (decipher)
+  @param[in]  r->Nc		size
+  @param[in]  mode   		0 = encipher, any other value decipher
+
+  @return SW code
+  @retval S0x6985 - conditions not satisfied - wrong nonce, key or tag
+  @retval S0x6700 - wrong length
+ */
+static uint8_t chacha_cipher(struct iso7816_response *r, uint8_t mode)
+{
+	uint8_t key[CHACHA20_KEY_LEN];
+	uint16_t size = r->Nc;
+	uint8_t ret;
+
+	DPRINT("%s mode %s\n", __FUNCTION__, mode ? "decipher" : "encipher");
+
+	// Wait for full APDU if chaining is active
+	if (r->chaining_state & APDU_CHAIN_RUNNING) {
+		DPRINT("APDU chaining is active, waiting more data\n");
+		return S_RET_OK;
+	}
+	if (i_vector_len != CHACHA20_NONCE_LEN || !(sec_env_valid & SENV_INIT_VECTOR))
+		return S0x6985;	//    Conditions not satisfied
+
+	if (mode) {
+		if (size < POLY1305_TAG_LEN)
+			return S0x6700;	//Incorrect length
+		size -= POLY1305_TAG_LEN;
+	} else if (size + POLY1305_TAG_LEN > APDU_RESP_LEN)
+		return S0x6700;	//Incorrect length
+
+	if (CHACHA20_KEY_LEN != fs_key_read_part(NULL, 0xa0))
+		return S0x6985;	//    Conditions not satisfied
+	fs_key_read_part(key, 0xa0);
+
+	ret = chacha20_poly1305(r->data, size, key, i_vector, r->data + size, mode);
+	memset(key, 0, sizeof(key));
+	// do not allow reuse of nonce for next encipher
+	if (!mode) {
+		sec_env_valid &= ~SENV_INIT_VECTOR;
+		i_vector_len = 0;
+	}
+	if (ret) {
+		DPRINT("tag check fail\n");
+		return S0x6985;	//    Conditions not satisfied
+	}
+	RESP_READY(mode ? size : size + POLY1305_TAG_LEN);
+}
+#endif
+
 static uint8_t decipher(struct iso7816_response *r)
 {
 	uint8_t ret;
@@ -990,6 +1483,13 @@ static uint8_t decipher(struct iso7816_response *r)
 
 // check key type, if DES/AES key is selected
 	ret = fs_get_file_type();
+#ifdef CHACHA20_POLY1305
+	if (ret == CHACHA_KEY_EF) {
+		if (M_P2 != 0x84)
+			return S0x6a86;	//Incorrect parameters P1-P2
+		return chacha_cipher(r, 1);
+	}
+#endif
 	if (ret == DES_KEY_EF || ret == AES_KEY_EF) {
 		// 0x86 is not allowed for symmetric cyphers
 		if (M_P2 != 0x84)
@@ -1115,9 +1615,134 @@ static uint8_t security_operation_encrypt(struct iso7816_response *r)
 	// select key back
 	fs_select_uuid(uuid, NULL);
 	DPRINT("return encrypted data, cla = %02x\n", r->input[0]);
+#ifdef CHACHA20_POLY1305
+	if (fs_get_file_type() == CHACHA_KEY_EF)
+		return chacha_cipher(r, 0);
+#endif
 	return des_aes_cipher(r, 0);
 }
 
+#ifdef AES_CMAC
+// CBC-MAC, chaining value in i_vector_tmp, len must be multiple of 16
+static void aes_cbc_mac(uint8_t * p, uint16_t len, uint8_t * key, uint8_t ksize)
+{
+	uint8_t i;
+
+#if defined (AES_NI) && defined (AES_CTX)
+	if (aes_ctx_hw) {
+		aes_cbc_hw_ctx(&aes_ctx, p, len, i_vector_tmp, 0);
+		return;
+	}
+#elif defined (AES_NI)
+	if (aes_cbc_hw(p, len, key, ksize, i_vector_tmp, 0))
+		return;
+#endif
+	for (; len; len -= 16, p += 16) {
+		for (i = 0; i < 16; i++)
+			i_vector_tmp[i] ^= p[i];
+		aes_ecb_encrypt(i_vector_tmp, 16, key, ksize);
+	}
+}
+
+// CMAC subkey: k = k * x in GF(2^128)
+static void cmac_dbl(uint8_t * k)
+{
+	uint8_t i, c;
+
+	c = -(k[0] >> 7) & 0x87;
+	for (i = 0; i < 15; i++)
+		k[i] = (k[i] << 1) | (k[i + 1] >> 7);
+	k[15] = (k[15] << 1) ^ c;
+}
+
+/*!
+  @brief AES-CMAC (NIST SP 800-38B)
+
+  Data to be authenticated can be sent in chained APDUs, all APDUs except
+  last APDU of chain must contain multiple of 16 bytes, only last APDU
+  returns MAC (16 bytes).  Security environment must be set as for
+  encipher, with algorithm reference 0x0E.
+
+  @param[in]  r->data		data to be authenticated
+  @param[out] r->data		MAC
+  @param[in]  r->Nc		size
+
+  @return SW code
+  @retval S0x6700 - wrong length
+  @retval S0x6985 - conditions not satisfied - wrong sec. env, unable to read key
+  @retval S0x6981 - incorect file type - not AES key
+ */
+static uint8_t security_operation_cmac(struct iso7816_response *r)
+{
+	uint8_t *key = r->input;
+	uint8_t *p = r->data;
+	uint16_t size = r->Nc;
+	uint16_t last;
+	uint8_t k[16];
+	uint8_t ksize, i, n;
+
+	DPRINT("%s chain state %d\n", __FUNCTION__, r->chaining_state);
+
+	if ((sec_env_valid &
+	     (SENV_TEMPL_MASK | SENV_ENCIPHER | SENV_FILE_REF | SENV_REF_ALGO)) !=
+	    (SENV_TEMPL_CT | SENV_ENCIPHER | SENV_FILE_REF | SENV_REF_ALGO)
+	    || sec_env_reference_algo != ALGO_AES_CMAC) {
+		DPRINT("security env not valid\n");
+		return S0x6985;	//    Conditions not satisfied
+	}
+	// there is over 256 bytes free in input, fs_key_read_part() return at max 256 bytes
+	ksize = fs_key_read_part(key, 0xa0);
+	if (!ksize)
+		return S0x6985;	//    Conditions not satisfied
+	if (fs_get_file_type() != AES_KEY_EF || (ksize != 16 && ksize != 24 && ksize != 32))
+		return S0x6981;	//incorect file type
+
+#ifdef AES_CTX
+	if (r->chaining_state <= APDU_CHAIN_START || aes_ctx_uuid != fs_get_selected_uuid()) {
+		aes_ctx_setup(key, ksize);
+		aes_ctx_uuid = fs_get_selected_uuid();
+	}
+#endif
+	if (r->chaining_state <= APDU_CHAIN_START)
+		memset(i_vector_tmp, 0, 16);
+
+	if (r->chaining_state & APDU_CHAIN_RUNNING) {
+		if (size & 15)
+			return S0x6700;	//Incorrect length
+		aes_cbc_mac(p, size, key, ksize);
+		// nothing is returned, drop already parsed data
+		r->chain_len = 0;
+		return S_RET_OK;
+	}
+	// all blocks except last (complete or incomplete) block
+	last = size ? (size - 1) & ~15 : 0;
+	aes_cbc_mac(p, last, key, ksize);
+	n = size - last;
+
+	// subkeys K1 (complete block) or K2 (padded block)
+	memset(k, 0, 16);
+	aes_ecb_encrypt(k, 16, key, ksize);
+	cmac_dbl(k);
+	if (n < 16)
+		cmac_dbl(k);
+	for (i = 0; i < 16; i++) {
+		if (i < n)
+			k[i] ^= p[last + i];
+		else if (i == n)
+			k[i] ^= 0x80;
+	}
+	aes_cbc_mac(k, 16, key, ksize);
+
+	memcpy(r->data, i_vector_tmp, 16);
+	memset(k, 0, 16);
+	memset(i_vector_tmp, 0, 16);
+#ifdef AES_CTX
+	memset(&aes_ctx, 0, sizeof(aes_ctx));
+#endif
+	RESP_READY(16);
+}
+#endif
+
 static uint8_t security_operation_decrypt(struct iso7816_response *r)
 {
 	uint8_t ret;
@@ -1179,8 +1804,12 @@ static void select_back_and_deauth(uint16_t uuid)
 
 	auth_id = (fs_get_file_proflag() >> 12);
 	// if here is 0, do not call fs_deauth() - it would deauth all PINs
-	if (auth_id)
+	if (auth_id) {
 		fs_deauth(auth_id);
+#ifdef ECDSA_PRECOMPUTE
+		ecdsa_precompute_clear();
+#endif
+	}
 
 	fs_select_uuid(uuid, NULL);	// select back old file
 }
@@ -1199,6 +1828,46 @@ static void select_back_and_deauth(uint16_t uuid)
 // rest 110-254 ec_point_t
 
 #define L_ECDH_OFFSET 110
+#ifdef CURVE25519
+// message is reused for private key, peer public key and shared secret
+static uint8_t x25519_derive(uint8_t * message, uint8_t * peer, uint8_t len,
+			     struct iso7816_response *r)
+{
+	bignum_t *k = (bignum_t *) message;
+	bignum_t *u = k + 1;
+	bignum_t *s = k + 2;
+	uint16_t uuid;
+	uint8_t dret;
+
+	if (len != 32) {
+		DPRINT("Incorrect length of X25519 public key %d\n", len);
+		return S0x6984;	// Invalid data
+	}
+	memset(message, 0, 3 * sizeof(bignum_t));
+	memcpy(u, peer, 32);
+	if (32 != fs_key_read_part(NULL, KEY_EC_PRIVATE))
+		return S0x6985;	//    Conditions not satisfied
+	fs_key_read_part((uint8_t *) k, KEY_EC_PRIVATE);
+
+	uuid = fs_get_selected_uuid();	// save old selected file
+	fs_select_uuid(key_file_uuid, NULL);
+	// this is  long operation, start sending NULL
+	card_io_start_null();
+
+	dret = x25519(s, k, u);
+	memset(k, 0, sizeof(bignum_t));
+
+	select_back_and_deauth(uuid);
+
+	if (dret)
+		return S0x6985;	//    Conditions not satisfied
+
+	memcpy(r->data, s, 32);
+	memset(s, 0, sizeof(bignum_t));
+	RESP_READY(32);
+}
+#endif
+
 uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r)
 {
 #if MP_BYTES > 48
@@ -1214,6 +1883,7 @@ uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r)
 	uint8_t ret, dret;
 	uint8_t t_len, *t;
 	uint8_t tg, tl;
+	uint8_t ui = 4;
 	uint16_t uuid;
 
 	DPRINT("%s %02x %02x\n", __FUNCTION__, M_P1, M_P2);
@@ -1277,7 +1947,17 @@ uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r)
 			return S0x6984;	// Invalid data
 		}
 		if (tg == 0x85) {
-			if (*t++ != 0x04)	// unexpanded point indicator
+#ifdef CURVE25519
+			// X25519 public key: u coordinate only, no point indicator
+			if (fs_get_file_type() == X25519_KEY_EF) {
+				if (tl != t_len)
+					return S0x6984;	// Invalid data
+				break;
+			}
+#endif
+			// uncompressed (04) or compressed (02, 03) point indicator
+			ui = *t++;
+			if (ui != 0x04 && ui != 0x02 && ui != 0x03)
 				return S0x6984;	// Invalid data
 			if (tl != t_len)
 				return S0x6984;	// Invalid data
@@ -1291,27 +1971,36 @@ uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r)
 			return S0x6984;	// Invalid data
 		}
 	}
+#ifdef CURVE25519
+	if (fs_get_file_type() == X25519_KEY_EF)
+		return x25519_derive(message, t, t_len, r);
+#endif
 	// prepare Ec constant, use size based on key  (key from selected file)
 	ret = prepare_ec_param(ec, NULL, 0);
 	if (ret == 0) {
 		DPRINT("Error, unable to get EC parameters/key\n");
 		return S0x6985;	//    Conditions not satisfied
 	}
-	if (ret * 2 != t_len) {
+	if ((ui == 4 ? ret * 2 : ret) != t_len) {
 		DPRINT
 		    ("Incorrect length of point data %d, selected file need %d bytes\n",
-		     t_len, ret * 2);
+		     t_len, ui == 4 ? ret * 2 : ret);
 		return S0x6984;	// Invalid data
 	}
 	reverse_copy((uint8_t *) & (derived_key->X), t, ec->mp_size);
-	reverse_copy((uint8_t *) & (derived_key->Y), t + ret, ec->mp_size);
+	if (ui == 4)
+		reverse_copy((uint8_t *) & (derived_key->Y), t + ret, ec->mp_size);
 
 	uuid = fs_get_selected_uuid();	// save old selected file
 	fs_select_uuid(key_file_uuid, NULL);
 	// this is  long operation, start sending NULL
 	card_io_start_null();
 
-	dret = ec_derive_key(derived_key, ec);
+	dret = 0;
+	if (ui != 4)
+		dret = ec_point_decompress(derived_key, ui, ec);
+	if (!dret)
+		dret = ec_derive_key(derived_key, ec);
 
 	select_back_and_deauth(uuid);
 
@@ -1322,6 +2011,163 @@ uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r)
 	RESP_READY(ret);
 }
 
+#ifdef ECIES
+// KDF output: AES key (up to 32 bytes) and HMAC-SHA256 key (32 bytes)
+#define ECIES_KM_LEN (32 + SHA256_DIGEST_LEN)
+
+// ANSI X9.63 KDF (SHA256, empty SharedInfo)
+static void ecies_kdf_x963(uint8_t * km, uint8_t * z, uint8_t zlen)
+{
+	sha256_ctx_t ctx;
+	uint8_t counter[4] = { 0, 0, 0, 0 };
+	uint8_t i;
+
+	for (i = 0; i < ECIES_KM_LEN; i += SHA256_DIGEST_LEN) {
+		counter[3]++;
+		sha256_init(&ctx);
+		sha256_update(&ctx, z, zlen);
+		sha256_update(&ctx, counter, 4);
+		sha256_final(&ctx, km + i);
+	}
+}
+
+// HKDF-SHA256 (RFC 5869, no salt, empty info)
+static void ecies_kdf_hkdf(uint8_t * km, uint8_t * z, uint8_t zlen)
+{
+	hmac_sha256_ctx_t hctx;
+	uint8_t prk[SHA256_DIGEST_LEN];
+	uint8_t i, counter = 0;
+
+	memset(prk, 0, sizeof(prk));
+	hmac_sha256_init(&hctx, prk, sizeof(prk));
+	hmac_sha256_update(&hctx, z, zlen);
+	hmac_sha256_final(&hctx, prk);
+
+	for (i = 0; i < ECIES_KM_LEN; i += SHA256_DIGEST_LEN) {
+		counter++;
+		hmac_sha256_init(&hctx, prk, sizeof(prk));
+		if (i)
+			hmac_sha256_update(&hctx, km + i - SHA256_DIGEST_LEN,
+					   SHA256_DIGEST_LEN);
+		hmac_sha256_update(&hctx, &counter, 1);
+		hmac_sha256_final(&hctx, km + i);
+	}
+	memset(prk, 0, sizeof(prk));
+}
+
+// proprietary, ECIES decrypt: ECDH + KDF + HMAC-SHA256 check + AES-CBC decrypt
+// P1 = KDF (1 = ANSI X9.63, 2 = HKDF), P2 = AES key size (16, 24, 32)
+// data: ECDH template (as for myeid_ecdh_derive()), ciphertext, 32 bytes MAC
+// sec. env. must be set as for ECDH
+//
+// ECDH may reuse message (and r->data for MP_BYTES <= 48), ciphertext is
+// moved to the end of r->data (behind the area used by ECDH: template copy
+// and shared secret, shared secret is never longer than the template),
+// plaintext is then decrypted into start of r->data
+#if MP_BYTES > 48
+#define ECIES_CT_MIN_OFFSET(tlen) (tlen)
+#else
+// ECDH point at L_ECDH_OFFSET, one AES block and MAC must fit behind it
+#if APDU_RESP_LEN < L_ECDH_OFFSET + 3 * MP_BYTES + 16 + SHA256_DIGEST_LEN
+#error ECIES with MP_BYTES <= 48 needs larger response buffer (APDU_LARGE)
+#endif
+#define ECIES_CT_MIN_OFFSET(tlen) (L_ECDH_OFFSET + sizeof(ec_point_t))
+#endif
+uint8_t myeid_ecies_decrypt(uint8_t * message, struct iso7816_response *r)
+{
+	uint8_t km[ECIES_KM_LEN];
+	uint8_t mac[SHA256_DIGEST_LEN];
+	hmac_sha256_ctx_t hctx;
+	aes_ctx_t *actx = NULL;
+	uint8_t kdf, ksize;
+	uint16_t tlen, ct_len, i;
+	uint8_t ret, j, pad;
+	uint8_t *p, *ct;
+
+	DPRINT("%s %02x %02x\n", __FUNCTION__, M_P1, M_P2);
+
+	kdf = M_P1;
+	ksize = M_P2;
+	if ((kdf != 1 && kdf != 2) || (ksize != 16 && ksize != 24 && ksize != 32))
+		return S0x6a86;	//Incorrect parameters P1-P2
+
+	// length of ECDH template
+	if (r->Nc < 3 || message[5] != 0x7c)
+		return S0x6984;	// Invalid data
+	tlen = message[6];
+	if (tlen == 0x81)
+		tlen = message[7] + 1;
+	if (tlen > 0x81 || r->Nc < tlen + 2)
+		return S0x6984;	// Invalid data
+	tlen += 2;
+
+	// at least one AES block and MAC
+	ct_len = r->Nc - tlen;
+	if (ct_len < 16 + SHA256_DIGEST_LEN || (ct_len - SHA256_DIGEST_LEN) & 15)
+		return S0x6700;	// Incorrect length
+	if (ct_len > APDU_RESP_LEN - ECIES_CT_MIN_OFFSET(tlen))
+		return S0x6700;	// Incorrect length
+	ct = r->data + APDU_RESP_LEN - ct_len;
+	memcpy(ct, message + 5 + tlen, ct_len);
+	ct_len -= SHA256_DIGEST_LEN;
+
+	// shared secret into r->data
+	M_P1 = 0;
+	M_P2 = 0;
+	M_P3 = tlen;
+	ret = myeid_ecdh_derive(message, r);
+	if (ret != S0x6100)
+		return ret;
+
+	if (kdf == 1)
+		ecies_kdf_x963(km, r->data, r->len16);
+	else
+		ecies_kdf_hkdf(km, r->data, r->len16);
+	memset(r->data, 0, r->len16);
+
+	// MAC over ciphertext, constant time compare
+	hmac_sha256_init(&hctx, km + ksize, SHA256_DIGEST_LEN);
+	hmac_sha256_update(&hctx, ct, ct_len);
+	hmac_sha256_final(&hctx, mac);
+	for (ret = 0, j = 0; j < SHA256_DIGEST_LEN; j++)
+		ret |= mac[j] ^ ct[ct_len + j];
+	if (ret) {
+		DPRINT("ECIES MAC check fail\n");
+		ret = S0x6984;	// Invalid data
+		goto end;
+	}
+	// AES-CBC, zero IV, plaintext is always below ciphertext in r->data
+	actx = alloca(sizeof(aes_ctx_t));
+	aes_ctx_init(actx, km, ksize);
+	for (i = 0; i < ct_len; i += 16) {
+		p = r->data + i;
+		memcpy(p, ct + i, 16);
+		aes_ctx_run(actx, p, 1);
+		if (i)
+			for (j = 0; j < 16; j++)
+				p[j] ^= ct[i - 16 + j];
+	}
+	// PKCS#7 padding
+	pad = r->data[ct_len - 1];
+	ret = S0x6984;	// Invalid data
+	if (pad == 0 || pad > 16)
+		goto end;
+	for (j = 1; j <= pad; j++)
+		if (r->data[ct_len - j] != pad)
+			goto end;
+	ret = S_RET_OK;
+ end:
+	if (actx)
+		memset(actx, 0, sizeof(aes_ctx_t));
+	memset(km, 0, sizeof(km));
+	if (ret) {
+		memset(r->data, 0, ct_len);
+		return ret;
+	}
+	RESP_READY(ct_len - pad);
+}
+#endif
+
 uint8_t security_operation(uint8_t * message, struct iso7816_response *r)
 {
 	uint16_t uuid;
@@ -1337,6 +2183,7 @@ uint8_t security_operation(uint8_t * message, struct iso7816_response *r)
   or raise error Incorrect parameters P1-P2
 SIGNATURE: 9E 9A
 ENCIPHER:  84 00 || 84 80
+CHECKSUM:  8E 80 (AES-CMAC)
 DECIPHER:  00 84 || 80 84 || 00 86 || 80 86
 */
 	op = M_P1;
@@ -1346,6 +2193,10 @@ DECIPHER:  00 84 || 80 84 || 00 86 || 80 86
 		ret_data = 0x80;
 	// encipher
 	else if (op == 0x84) ;
+#ifdef AES_CMAC
+	// compute cryptographic checksum
+	else if (op == 0x8e && ret_data == 0x80) ;
+#endif
 	// decipher
 	else if (ret_data == 0x84 || ret_data == 0x86) {
 		ret_data = op;
@@ -1366,6 +2217,11 @@ DECIPHER:  00 84 || 80 84 || 00 86 || 80 86
 	case 0x84:
 		ret = security_operation_encrypt(r);
 		break;
+#ifdef AES_CMAC
+	case 0x8e:
+		ret = security_operation_cmac(r);
+		break;
+#endif
 	case 0:
 		// for UNWRAP operation - only SW is returned, clear Ne
 		if (!ret_data)
@@ -1379,6 +2235,38 @@ DECIPHER:  00 84 || 80 84 || 00 86 || 80 86
 	return ret;
 }
 
+#if ECDSA_BATCH_MAX > 0
+// proprietary, sign more HASHes in one APDU, sec. env. must be set as for ECDSA sign
+uint8_t myeid_ecdsa_sign_batch(uint8_t * message, struct iso7816_response *r)
+{
+	uint16_t uuid;
+	uint8_t ret;
+
+	DPRINT("%s %02x %02x\n", __FUNCTION__, M_P1, M_P2);
+
+	if (M_P1 != 0 || M_P2 != 0)
+		return S0x6a86;	//Incorrect parameters P1-P2
+
+	if ((sec_env_valid &
+	     (SENV_TEMPL_MASK | SENV_ENCIPHER | SENV_FILE_REF | SENV_REF_ALGO)) !=
+	    (SENV_TEMPL_DST | SENV_FILE_REF | SENV_REF_ALGO) || sec_env_reference_algo != 4) {
+		DPRINT("invalid sec env (%02x) or algo (%02x)\n", sec_env_valid,
+		       sec_env_reference_algo);
+		return S0x6985;	//    Conditions not satisfied
+	}
+	// Wait for full APDU if chaining is active
+	if (r->chaining_state & APDU_CHAIN_RUNNING) {
+		DPRINT("APDU chaining is active, waiting more data\n");
+		return S_RET_OK;
+	}
+	uuid = fs_get_selected_uuid();	// save old selected file
+	fs_select_uuid(key_file_uuid, NULL);
+	ret = sign_ec_batch(r->input + 5, r, r->Nc);
+	select_back_and_deauth(uuid);
+	return ret;
+}
+#endif
+
 static __attribute__((noinline))
 uint8_t myeid_generate_rsa_key(uint8_t * message, struct iso7816_response *r)
 {
@@ -1576,6 +2464,42 @@ Use public key with "uncompressed" indicator (byte 04 at start)
 	RESP_READY(ret + add);
 }
 
+#ifdef CURVE25519
+// X25519/Ed25519 key, public and private key are stored in RFC 7748/8032
+// byte order (little endian)
+static uint8_t c25519_generate_key(uint8_t type, struct iso7816_response *r)
+{
+	uint8_t ret;
+	struct x25519_key {
+		uint8_t type;
+		uint8_t size;
+		bignum_t key;
+	};
+	struct x25519_key *priv = (struct x25519_key *)r->data;
+	struct x25519_key *pub = priv + 1;
+
+	if (type == ED25519_KEY_EF)
+		ed25519_key_gener(pub->key.value, priv->key.value);
+	else if (x25519_key_gener(&pub->key, &priv->key)) {
+		DPRINT("Key wrong\n");
+		return S0x6985;	//    Conditions not satisfied
+	}
+	priv->type = KEY_EC_PRIVATE | KEY_GENERATE;
+	priv->size = 32;
+	ret = fs_key_write_part((uint8_t *) priv);
+	memset(priv, 0, sizeof(struct x25519_key));
+	if (ret != S_RET_OK)
+		return ret;
+
+	pub->type = KEY_EC_PUBLIC | KEY_GENERATE;
+	pub->size = 32;
+	ret = fs_key_write_part((uint8_t *) pub);
+	if (ret != S_RET_OK)
+		return ret;
+	return ec_read_public_key(r, 0x86);
+}
+#endif
+
 // generate key, file is already selected,
 // key type/size can be determined only from file size/file type
 // file type 0x11:
@@ -1639,6 +2563,10 @@ uint8_t myeid_generate_key(uint8_t * message, struct iso7816_response *r)
 
 	DPRINT("Generating key, selected file 0x%04x, key size %d bits\n",
 	       fs_get_selected(), k_size);
+#ifdef CURVE25519
+	if ((type & 0xfe) == X25519_KEY_EF)
+		return c25519_generate_key(type, r);
+#endif
 
 	if (0 == prepare_ec_param(c, &(pub_key->key), (k_size + 7) / 8)) {
 		DPRINT("Wrong EC parameteres\n");
@@ -1678,6 +2606,119 @@ uint8_t myeid_generate_key(uint8_t * message, struct iso7816_response *r)
 	return ec_read_public_key(r, 0x86);
 }
 
+#if EC_KEYGEN_BATCH_MAX > 0
+// proprietary, generate EC keys into more key files (in current DF), data
+// field: list of file IDs (2 bytes each), curve is determined by key file
+// type/size as in myeid_generate_key(). Response: concatenated public keys
+// (tag 0x86, same format as in myeid_generate_key())
+uint8_t myeid_generate_key_batch(uint8_t * message, struct iso7816_response *r)
+{
+	uint16_t id[EC_KEYGEN_BATCH_MAX];
+	uint16_t uuid, k_size, len;
+	uint8_t count, i, j, type, size, ret;
+	uint8_t *parts, *pub;
+
+	DPRINT("%s %02x %02x\n", __FUNCTION__, M_P1, M_P2);
+
+	if (M_P1 != 0 || M_P2 != 0)
+		return S0x6a86;	//Incorrect parameters P1-P2
+
+	count = M_P3 / 2;
+	if (M_P3 & 1 || count == 0 || count > EC_KEYGEN_BATCH_MAX)
+		return S0x6700;	// Incorrect length
+
+	for (i = 0; i < count; i++) {
+		id[i] = message[5 + 2 * i] << 8 | message[6 + 2 * i];
+		// same key file can not be used twice
+		for (j = 0; j < i; j++)
+			if (id[j] == id[i])
+				return S0x6a80;	// incorrect data
+	}
+
+	struct ec_param *c = alloca(sizeof(struct ec_param));
+	ec_point_t *p = alloca(sizeof(ec_point_t));
+	// private key part + public key part (with 0x04 uncompressed indicator)
+	parts = alloca(2 + MP_BYTES + 3 + 2 * MP_BYTES);
+
+	uuid = fs_get_selected_uuid();	// save old selected file
+
+	// check all key files (type, ACL, free space for key parts), and if
+	// all public keys fit into response, no key is generated if any check fails
+	for (len = 0, i = 0; i < count; i++) {
+		ret = S0x6a82;	// file not found
+		if (S0x6100 != fs_select_ef(id[i], NULL))
+			goto end;
+		ret = S0x6985;	//    Conditions not satisfied
+		type = fs_get_file_type();
+		k_size = fs_get_file_size();
+		if (check_ec_key_file(k_size, type))
+			goto end;
+#ifdef CURVE25519
+		if ((type & 0xfe) == X25519_KEY_EF)
+			goto end;
+#endif
+		size = (k_size + 7) / 8;
+		// private key part + public key part (same as below)
+		ret = fs_key_ec_generate_check(2 + size + 2 + 2 * size + 1);
+		if (ret != S_RET_OK)
+			goto end;
+		len += 2 + 2 * size + 1;
+		if (2 * size + 1 > 128)
+			len++;
+	}
+	ret = S0x6700;	// Incorrect length
+	if (len > APDU_RESP_LEN)
+		goto end;
+
+	card_io_start_null();
+
+	for (len = 0, i = 0; i < count; i++) {
+		fs_select_ef(id[i], NULL);
+		k_size = fs_get_file_size();
+		DPRINT("Generating key, file 0x%04x, key size %d bits\n", id[i], k_size);
+		ret = S0x6985;	//    Conditions not satisfied
+		if (0 == prepare_ec_param(c, p, (k_size + 7) / 8)) {
+			DPRINT("Wrong EC parameteres\n");
+			goto end;
+		}
+		if (ec_key_gener(p, c)) {
+			DPRINT("Key wrong\n");
+			goto end;
+		}
+		size = c->mp_size;
+		parts[0] = KEY_EC_PRIVATE | KEY_GENERATE;
+		parts[1] = size;
+		reverse_copy(parts + 2, (uint8_t *) & (c->working_key), size);
+		memset(&(c->working_key), 0, sizeof(bignum_t));
+
+		pub = parts + 2 + size;
+		pub[0] = KEY_EC_PUBLIC | KEY_GENERATE;
+		pub[1] = 2 * size + 1;
+		pub[2] = 4;
+		reverse_copy(pub + 3, (uint8_t *) & (p->X), size);
+		reverse_copy(pub + 3 + size, (uint8_t *) & (p->Y), size);
+
+		ret = fs_key_write_parts(parts, 2 + size + 2 + pub[1]);
+		memset(parts, 0, 2 + size);
+		if (ret != S_RET_OK)
+			goto end;
+
+		// public key into response
+		r->data[len++] = 0x86;
+		if (pub[1] > 128)
+			r->data[len++] = 0x81;
+		r->data[len++] = pub[1];
+		memcpy(r->data + len, pub + 2, pub[1]);
+		len += pub[1];
+	}
+	fs_select_uuid(uuid, NULL);
+	RESP_READY(len);
+ end:
+	fs_select_uuid(uuid, NULL);
+	return ret;
+}
+#endif
+
 static uint8_t ecc_param(uint8_t v, uint8_t * response, struct iso7816_response *r)
 {
 	struct ec_param c;
@@ -1818,12 +2859,18 @@ static uint8_t myeid_upload_ec_key(uint8_t * message, uint16_t size)
 	if (M_P2 == 0x87)
 		message[3] = KEY_EC_PRIVATE;
 	else if (M_P2 == 0x86) {
-		// public key - two numbers and uncompressed indicator
-		key_bytes = 2 * key_bytes + 1;
 		message[3] = KEY_EC_PUBLIC;
-		// check uncompressed indicator
-		if (message[5] != 4)
-			return S0x6985;	//    Conditions not satisfied
+#ifdef CURVE25519
+		// X25519/Ed25519 public key - u coordinate/encoded point only
+		if ((fs_get_file_type() & 0xfe) != X25519_KEY_EF)
+#endif
+		{
+			// public key - two numbers and uncompressed indicator
+			key_bytes = 2 * key_bytes + 1;
+			// check uncompressed indicator
+			if (message[5] != 4)
+				return S0x6985;	//    Conditions not satisfied
+		}
 	} else
 		return S0x6a86;	// Incorrect parameters P1-P2
 	if (key_bytes != M_P3)
@@ -1922,6 +2969,13 @@ static uint8_t myeid_upload_keys(uint8_t * message)
 			return S0x6700;	//Incorrect length
 		return fs_key_write_part(message + 3);
 	}
+#ifdef CHACHA20_POLY1305
+	if (type == CHACHA_KEY_EF) {
+		if (k_size != 256)
+			return S0x6700;	//Incorrect length
+		return fs_key_write_part(message + 3);
+	}
+#endif
 	// file type is checked in check_ec_key_file(),
 	// size and key part type is checked in myeid_upload_ec_key()
 	if (0 == check_ec_key_file(k_size, type))
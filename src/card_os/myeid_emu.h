@@ -41,6 +41,25 @@ uint8_t myeid_activate_applet( __attribute__((unused)) uint8_t * message, __attr
 			      struct iso7816_response *r);
 
 uint8_t myeid_ecdh_derive(uint8_t * message, struct iso7816_response *r);
+#ifdef ECIES
+uint8_t myeid_ecies_decrypt(uint8_t * message, struct iso7816_response *r);
+#endif
+
+// maximal number of HASHes in one batch ECDSA sign APDU, 0 = disabled
+#ifndef ECDSA_BATCH_MAX
+#define ECDSA_BATCH_MAX 0
+#endif
+#if ECDSA_BATCH_MAX > 0
+uint8_t myeid_ecdsa_sign_batch(uint8_t * message, struct iso7816_response *r);
+#endif
+
+// maximal number of key files in one batch EC key generation APDU, 0 = disabled
+#ifndef EC_KEYGEN_BATCH_MAX
+#define EC_KEYGEN_BATCH_MAX 0
+#endif
+#if EC_KEYGEN_BATCH_MAX > 0
+uint8_t myeid_generate_key_batch(uint8_t * message, struct iso7816_response *r);
+#endif
 
 #ifdef HW_SERIAL_NUMBER
 void get_HW_serial_number(uint8_t * s);
@@ -29,4 +29,9 @@ void rnd_init (void);
 // for size == 0 return 256 bytes
 void rnd_get (uint8_t *rnd, uint8_t size);
 
+#ifdef CTR_DRBG
+// target entropy source, rnd_get() is served from CTR_DRBG (ctr_drbg.c)
+void rnd_hw_get (uint8_t *rnd, uint8_t size);
+#endif
+
 #endif
@@ -0,0 +1,189 @@
+/*
+    sha256.c
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    SHA256 (FIPS 180-4) and HMAC-SHA256 (RFC 2104), used by ECIES KDF/MAC
+
+    Code is designed for small size, not for speed.  Message length is
+    limited to 2^32 bytes.
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "sha256.h"
+
+static const uint32_t sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+  0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+  0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+  0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+  0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+  0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+  0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+  0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+  0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const uint32_t sha256_h0[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a,
+  0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+#define ROR(x,n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static uint32_t
+load32 (uint8_t * p)
+{
+  uint32_t r = 0;
+  uint8_t i;
+
+  for (i = 0; i < 4; i++)
+    r = (r << 8) | p[i];
+  return r;
+}
+
+static void
+store32 (uint8_t * p, uint32_t v)
+{
+  uint8_t i = 4;
+
+  while (i--)
+    {
+      p[i] = v;
+      v >>= 8;
+    }
+}
+
+static void
+sha256_block (sha256_ctx_t * ctx)
+{
+  uint32_t w[16];
+  uint32_t v[8];
+  uint32_t t1, t2, s0, s1;
+  uint8_t i;
+
+  for (i = 0; i < 16; i++)
+    w[i] = load32 (ctx->buf + 4 * i);
+  memcpy (v, ctx->h, sizeof (v));
+
+  for (i = 0; i < 64; i++)
+    {
+      // message schedule in 16 words circular buffer
+      if (i >= 16)
+	{
+	  s0 = w[(i + 1) & 15];
+	  s0 = ROR (s0, 7) ^ ROR (s0, 18) ^ (s0 >> 3);
+	  s1 = w[(i + 14) & 15];
+	  s1 = ROR (s1, 17) ^ ROR (s1, 19) ^ (s1 >> 10);
+	  w[i & 15] += s0 + s1 + w[(i + 9) & 15];
+	}
+      t1 = v[7] + (ROR (v[4], 6) ^ ROR (v[4], 11) ^ ROR (v[4], 25))
+	+ ((v[4] & v[5]) ^ (~v[4] & v[6])) + sha256_k[i] + w[i & 15];
+      t2 = (ROR (v[0], 2) ^ ROR (v[0], 13) ^ ROR (v[0], 22))
+	+ ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+      memmove (v + 1, v, 7 * sizeof (uint32_t));
+      v[4] += t1;
+      v[0] = t1 + t2;
+    }
+  for (i = 0; i < 8; i++)
+    ctx->h[i] += v[i];
+}
+
+void
+sha256_init (sha256_ctx_t * ctx)
+{
+  memcpy (ctx->h, sha256_h0, sizeof (ctx->h));
+  ctx->len = 0;
+}
+
+void
+sha256_update (sha256_ctx_t * ctx, uint8_t * data, uint16_t len)
+{
+  uint8_t fill;
+
+  while (len--)
+    {
+      fill = ctx->len & 63;
+      ctx->buf[fill] = *data++;
+      ctx->len++;
+      if (fill == 63)
+	sha256_block (ctx);
+    }
+}
+
+void
+sha256_final (sha256_ctx_t * ctx, uint8_t * hash)
+{
+  uint8_t fill = ctx->len & 63;
+  uint8_t i;
+
+  ctx->buf[fill++] = 0x80;
+  if (fill > 56)
+    {
+      memset (ctx->buf + fill, 0, 64 - fill);
+      sha256_block (ctx);
+      fill = 0;
+    }
+  memset (ctx->buf + fill, 0, 59 - fill);
+  // 64 bit length in bits (upper bits from 32 bit byte counter)
+  ctx->buf[59] = ctx->len >> 29;
+  store32 (ctx->buf + 60, ctx->len << 3);
+  sha256_block (ctx);
+
+  for (i = 0; i < 8; i++)
+    store32 (hash + 4 * i, ctx->h[i]);
+  memset (ctx, 0, sizeof (sha256_ctx_t));
+}
+
+void
+hmac_sha256_init (hmac_sha256_ctx_t * hctx, uint8_t * key, uint8_t len)
+{
+  uint8_t i;
+
+  memset (hctx->key, 0, 64);
+  memcpy (hctx->key, key, len);
+  for (i = 0; i < 64; i++)
+    hctx->key[i] ^= 0x36;
+  sha256_init (&hctx->ctx);
+  sha256_update (&hctx->ctx, hctx->key, 64);
+}
+
+void
+hmac_sha256_update (hmac_sha256_ctx_t * hctx, uint8_t * data, uint16_t len)
+{
+  sha256_update (&hctx->ctx, data, len);
+}
+
+void
+hmac_sha256_final (hmac_sha256_ctx_t * hctx, uint8_t * mac)
+{
+  uint8_t i;
+
+  sha256_final (&hctx->ctx, mac);
+  // ipad -> opad
+  for (i = 0; i < 64; i++)
+    hctx->key[i] ^= 0x36 ^ 0x5c;
+  sha256_init (&hctx->ctx);
+  sha256_update (&hctx->ctx, hctx->key, 64);
+  sha256_update (&hctx->ctx, mac, SHA256_DIGEST_LEN);
+  sha256_final (&hctx->ctx, mac);
+  memset (hctx, 0, sizeof (hmac_sha256_ctx_t));
+}
@@ -0,0 +1,53 @@
+/*
+    sha256.h
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    SHA256 and HMAC-SHA256 header file
+
+*/
+#ifndef _SHA256_H_
+#define _SHA256_H_
+
+#define SHA256_DIGEST_LEN 32
+
+typedef struct
+{
+  uint32_t h[8];
+  uint32_t len;			// message length in bytes
+  uint8_t buf[64];
+} sha256_ctx_t;
+
+void sha256_init (sha256_ctx_t * ctx);
+void sha256_update (sha256_ctx_t * ctx, uint8_t * data, uint16_t len);
+// write 32 bytes of digest into hash, ctx is cleared
+void sha256_final (sha256_ctx_t * ctx, uint8_t * hash);
+
+typedef struct
+{
+  sha256_ctx_t ctx;
+  uint8_t key[64];		// key XORed with ipad
+} hmac_sha256_ctx_t;
+
+// key length up to 64 bytes
+void hmac_sha256_init (hmac_sha256_ctx_t * hctx, uint8_t * key, uint8_t len);
+void hmac_sha256_update (hmac_sha256_ctx_t * hctx, uint8_t * data,
+			 uint16_t len);
+// write 32 bytes of MAC into mac, hctx is cleared
+void hmac_sha256_final (hmac_sha256_ctx_t * hctx, uint8_t * mac);
+#endif
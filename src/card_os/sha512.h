@@ -0,0 +1,40 @@
+/*
+    sha512.h
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2015-2023 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    SHA512 header file
+
+*/
+#ifndef _SHA512_H_
+#define _SHA512_H_
+
+#define SHA512_DIGEST_LEN 64
+
+typedef struct
+{
+  uint64_t h[8];
+  uint64_t len;			// message length in bytes
+  uint8_t buf[128];
+} sha512_ctx_t;
+
+void sha512_init (sha512_ctx_t * ctx);
+void sha512_update (sha512_ctx_t * ctx, uint8_t * data, uint16_t len);
+// write 64 bytes of digest into hash, ctx is cleared
+void sha512_final (sha512_ctx_t * ctx, uint8_t * hash);
+#endif
@@ -51,8 +51,13 @@ rnd_init (void)
   adc_base[8] = 0x42;
 }
 
+#ifdef CTR_DRBG
+void
+rnd_hw_get (uint8_t * r, uint8_t size)
+#else
 void
 rnd_get (uint8_t * r, uint8_t size)
+#endif
 {
   uint8_t v;
   uint8_t pos = 0, b;
@@ -53,7 +53,11 @@ static uint32_t entropy_crc(uint32_t crc, uint8_t n)
 	return ~crc;
 }
 
+#ifdef CTR_DRBG
+void rnd_hw_get(uint8_t * r, uint8_t size)
+#else
 void rnd_get(uint8_t * r, uint8_t size)
+#endif
 {
 	static uint32_t __attribute__((section(".noinit"))) random;
 	volatile uint32_t *address = (uint32_t *) (ADC1_BASE);
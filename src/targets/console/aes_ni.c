@@ -0,0 +1,374 @@
+/*
+    aes_ni.c
+
+    This is part of OsEID (Open source Electronic ID)
+
+    Copyright (C) 2026 Peter Popovec, popovec.peter@gmail.com
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+    Emulator on x86, AES by AES-NI instructions
+
+    aes_run() overrides weak generic version from card_os/aes.c,
+    aes_cbc_hw() runs whole CBC (or ECB) operation.  aes_cbc_hw_ctx() does
+    the same with round keys stored in aes_ctx_t by aes_ctx_hw_init(), so
+    the key is expanded only once for more calls.  AES-NI availability is
+    checked by CPUID at runtime, generic code is used if AES-NI is not
+    available (or on non x86 host).
+
+    If compiled with AES_CTR_GCM, gf128_mul() (GHASH) by PCLMULQDQ
+    overrides weak generic version from card_os/gcm.c.
+
+*/
+#include <stdint.h>
+#include <string.h>
+#include "aes.h"
+#ifdef AES_CTR_GCM
+#include "gcm.h"
+#endif
+
+#if defined (__x86_64__) || defined (__i386__)
+#include <immintrin.h>
+
+#define AES_NI_TARGET __attribute__ ((target ("aes,sse2")))
+
+typedef struct
+{
+  __m128i ek[15];
+  __m128i dk[15];
+  uint8_t rounds;
+} aes_ni_key_t;
+
+// aes_ni_key_t is stored in aes_ctx_t ta[] (aes_ctx_hw_init)
+typedef char aes_ni_key_fits_ctx[sizeof (aes_ni_key_t) <=
+				 sizeof (((aes_ctx_t *) 0)->ta) ? 1 : -1];
+
+static int8_t aes_ni_present = -1;
+
+static uint8_t
+aes_ni_check (void)
+{
+  if (aes_ni_present < 0)
+    {
+      __builtin_cpu_init ();
+      aes_ni_present = __builtin_cpu_supports ("aes") ? 1 : 0;
+    }
+  return aes_ni_present;
+}
+
+// SubWord() by AESKEYGENASSIST (SubWord of 2nd dword is returned in 1st dword)
+static uint32_t AES_NI_TARGET
+aes_ni_subword (uint32_t w)
+{
+  return _mm_cvtsi128_si32 (_mm_aeskeygenassist_si128
+			    (_mm_set_epi32 (0, 0, w, 0), 0));
+}
+
+// FIPS 197 key expansion (words in little endian)
+static void AES_NI_TARGET
+aes_ni_expand (aes_ni_key_t * k, uint8_t * key, uint8_t keysize)
+{
+  uint32_t w[60];
+  uint32_t t, rcon = 1;
+  uint8_t i, nk = keysize / 4;
+
+  k->rounds = nk + 6;
+  memcpy (w, key, keysize);
+  for (i = nk; i < 4 * (k->rounds + 1); i++)
+    {
+      t = w[i - 1];
+      if (i % nk == 0)
+	{
+	  t = aes_ni_subword ((t >> 8) | (t << 24)) ^ rcon;
+	  rcon = (rcon << 1) ^ ((rcon >> 7) * 0x11b);
+	}
+      else if (nk > 6 && i % nk == 4)
+	t = aes_ni_subword (t);
+      w[i] = w[i - nk] ^ t;
+    }
+  for (i = 0; i <= k->rounds; i++)
+    k->ek[i] = _mm_loadu_si128 ((__m128i *) (w + 4 * i));
+  // equivalent inverse cipher keys
+  k->dk[0] = k->ek[k->rounds];
+  for (i = 1; i < k->rounds; i++)
+    k->dk[i] = _mm_aesimc_si128 (k->ek[k->rounds - i]);
+  k->dk[k->rounds] = k->ek[0];
+  memset (w, 0, sizeof (w));
+}
+
+static __m128i AES_NI_TARGET
+aes_ni_enc (aes_ni_key_t * k, __m128i b)
+{
+  uint8_t i;
+
+  b = _mm_xor_si128 (b, k->ek[0]);
+  for (i = 1; i < k->rounds; i++)
+    b = _mm_aesenc_si128 (b, k->ek[i]);
+  return _mm_aesenclast_si128 (b, k->ek[i]);
+}
+
+static __m128i AES_NI_TARGET
+aes_ni_dec (aes_ni_key_t * k, __m128i b)
+{
+  uint8_t i;
+
+  b = _mm_xor_si128 (b, k->dk[0]);
+  for (i = 1; i < k->rounds; i++)
+    b = _mm_aesdec_si128 (b, k->dk[i]);
+  return _mm_aesdeclast_si128 (b, k->dk[i]);
+}
+
+// 4 blocks encrypt (ECB/CTR), independent blocks are interleaved in pipeline
+static void AES_NI_TARGET
+aes_ni_enc4 (aes_ni_key_t * k, __m128i * b)
+{
+  uint8_t i, j;
+
+  for (j = 0; j < 4; j++)
+    b[j] = _mm_xor_si128 (b[j], k->ek[0]);
+  for (i = 1; i < k->rounds; i++)
+    for (j = 0; j < 4; j++)
+      b[j] = _mm_aesenc_si128 (b[j], k->ek[i]);
+  for (j = 0; j < 4; j++)
+    b[j] = _mm_aesenclast_si128 (b[j], k->ek[i]);
+}
+
+// 4 blocks decrypt, independent blocks are interleaved in pipeline
+static void AES_NI_TARGET
+aes_ni_dec4 (aes_ni_key_t * k, __m128i * b)
+{
+  uint8_t i, j;
+
+  for (j = 0; j < 4; j++)
+    b[j] = _mm_xor_si128 (b[j], k->dk[0]);
+  for (i = 1; i < k->rounds; i++)
+    for (j = 0; j < 4; j++)
+      b[j] = _mm_aesdec_si128 (b[j], k->dk[i]);
+  for (j = 0; j < 4; j++)
+    b[j] = _mm_aesdeclast_si128 (b[j], k->dk[i]);
+}
+
+static void AES_NI_TARGET
+aes_ni_cbc (uint8_t * data, uint16_t len, aes_ni_key_t * k, uint8_t * iv,
+	    uint8_t mode)
+{
+  __m128i v, c[4], p[4];
+  uint8_t j;
+
+  v = iv ? _mm_loadu_si128 ((__m128i *) iv) : _mm_setzero_si128 ();
+  if (mode == 0)
+    {
+      // ECB, blocks are independent
+      if (!iv)
+	for (; len >= 64; len -= 64, data += 64)
+	  {
+	    for (j = 0; j < 4; j++)
+	      p[j] = _mm_loadu_si128 ((__m128i *) data + j);
+	    aes_ni_enc4 (k, p);
+	    for (j = 0; j < 4; j++)
+	      _mm_storeu_si128 ((__m128i *) data + j, p[j]);
+	  }
+      for (; len; len -= 16, data += 16)
+	{
+	  p[0] = _mm_loadu_si128 ((__m128i *) data);
+	  if (iv)
+	    p[0] = _mm_xor_si128 (p[0], v);
+	  v = aes_ni_enc (k, p[0]);
+	  _mm_storeu_si128 ((__m128i *) data, v);
+	}
+    }
+  else
+    {
+      for (; len >= 64; len -= 64, data += 64)
+	{
+	  for (j = 0; j < 4; j++)
+	    p[j] = c[j] = _mm_loadu_si128 ((__m128i *) data + j);
+	  aes_ni_dec4 (k, p);
+	  for (j = 0; j < 4; j++)
+	    {
+	      if (iv)
+		p[j] = _mm_xor_si128 (p[j], v);
+	      v = c[j];
+	      _mm_storeu_si128 ((__m128i *) data + j, p[j]);
+	    }
+	}
+      for (; len; len -= 16, data += 16)
+	{
+	  c[0] = _mm_loadu_si128 ((__m128i *) data);
+	  p[0] = aes_ni_dec (k, c[0]);
+	  if (iv)
+	    p[0] = _mm_xor_si128 (p[0], v);
+	  v = c[0];
+	  _mm_storeu_si128 ((__m128i *) data, p[0]);
+	}
+    }
+  // IV for next APDU in chain
+  if (iv)
+    _mm_storeu_si128 ((__m128i *) iv, v);
+}
+
+void
+aes_run (uint8_t * buf, uint8_t * key, uint8_t keysize, uint8_t mode)
+{
+  aes_ni_key_t k;
+  aes_ctx_t ctx;
+
+  if (aes_ni_check ())
+    {
+      aes_ni_expand (&k, key, keysize);
+      aes_ni_cbc (buf, 16, &k, NULL, mode);
+      memset (&k, 0, sizeof (k));
+      return;
+    }
+  aes_ctx_init (&ctx, key, keysize);
+  aes_ctx_run (&ctx, buf, mode);
+  memset (&ctx, 0, sizeof (ctx));
+}
+
+uint8_t
+aes_cbc_hw (uint8_t * data, uint16_t len, uint8_t * key, uint8_t keysize,
+	    uint8_t * iv, uint8_t mode)
+{
+  aes_ni_key_t k;
+
+  if (!aes_ni_check ())
+    return 0;
+  if (keysize != 16 && keysize != 24 && keysize != 32)
+    return 0;
+  aes_ni_expand (&k, key, keysize);
+  aes_ni_cbc (data, len, &k, iv, mode);
+  memset (&k, 0, sizeof (k));
+  return 1;
+}
+
+uint8_t
+aes_ctx_hw_init (aes_ctx_t * ctx, uint8_t * key, uint8_t keysize)
+{
+  if (!aes_ni_check ())
+    return 0;
+  if (keysize != 16 && keysize != 24 && keysize != 32)
+    return 0;
+  aes_ni_expand ((aes_ni_key_t *) ctx->ta, key, keysize);
+  ctx->rounds = keysize / 4 + 6;
+  return 1;
+}
+
+void
+aes_cbc_hw_ctx (aes_ctx_t * ctx, uint8_t * data, uint16_t len, uint8_t * iv,
+		uint8_t mode)
+{
+  aes_ni_cbc (data, len, (aes_ni_key_t *) ctx->ta, iv, mode);
+}
+
+#ifdef AES_CTR_GCM
+#define CLMUL_TARGET __attribute__ ((target ("pclmul,ssse3")))
+
+static int8_t clmul_present = -1;
+
+// carry-less multiplication, then reduction modulo x^128 + x^7 + x^2 + x + 1
+// (bit reflected, operands are byte swapped to get 128 bit integer)
+static void CLMUL_TARGET
+gf128_mul_clmul (uint8_t * x, uint8_t * h)
+{
+  const __m128i bswap =
+    _mm_set_epi8 (0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+  __m128i a, b, lo, hi, mid, t1, t2, t3;
+
+  a = _mm_shuffle_epi8 (_mm_loadu_si128 ((__m128i *) x), bswap);
+  b = _mm_shuffle_epi8 (_mm_loadu_si128 ((__m128i *) h), bswap);
+
+  lo = _mm_clmulepi64_si128 (a, b, 0x00);
+  hi = _mm_clmulepi64_si128 (a, b, 0x11);
+  mid = _mm_xor_si128 (_mm_clmulepi64_si128 (a, b, 0x10),
+		       _mm_clmulepi64_si128 (a, b, 0x01));
+  lo = _mm_xor_si128 (lo, _mm_slli_si128 (mid, 8));
+  hi = _mm_xor_si128 (hi, _mm_srli_si128 (mid, 8));
+
+  // 256 bit product hi:lo shifted left by one bit (reflected operands)
+  t1 = _mm_srli_epi32 (lo, 31);
+  t2 = _mm_srli_epi32 (hi, 31);
+  lo = _mm_slli_epi32 (lo, 1);
+  hi = _mm_slli_epi32 (hi, 1);
+  t3 = _mm_srli_si128 (t1, 12);
+  t2 = _mm_slli_si128 (t2, 4);
+  t1 = _mm_slli_si128 (t1, 4);
+  lo = _mm_or_si128 (lo, t1);
+  hi = _mm_or_si128 (hi, t2);
+  hi = _mm_or_si128 (hi, t3);
+
+  // reduction
+  t1 = _mm_xor_si128 (_mm_xor_si128 (_mm_slli_epi32 (lo, 31),
+				     _mm_slli_epi32 (lo, 30)),
+		      _mm_slli_epi32 (lo, 25));
+  t2 = _mm_srli_si128 (t1, 4);
+  t1 = _mm_slli_si128 (t1, 12);
+  lo = _mm_xor_si128 (lo, t1);
+  t3 = _mm_xor_si128 (_mm_xor_si128 (_mm_srli_epi32 (lo, 1),
+				     _mm_srli_epi32 (lo, 2)),
+		      _mm_srli_epi32 (lo, 7));
+  t3 = _mm_xor_si128 (t3, t2);
+  lo = _mm_xor_si128 (lo, t3);
+  hi = _mm_xor_si128 (hi, lo);
+
+  _mm_storeu_si128 ((__m128i *) x, _mm_shuffle_epi8 (hi, bswap));
+}
+
+void
+gf128_mul (uint8_t * x, uint8_t * h)
+{
+  if (clmul_present < 0)
+    {
+      __builtin_cpu_init ();
+      clmul_present = __builtin_cpu_supports ("pclmul") ? 1 : 0;
+    }
+  if (clmul_present)
+    gf128_mul_clmul (x, h);
+  else
+    gf128_mul_soft (x, h);
+}
+#endif
+#else
+uint8_t
+aes_cbc_hw (uint8_t * data, uint16_t len, uint8_t * key, uint8_t keysize,
+	    uint8_t * iv, uint8_t mode)
+{
+  (void) data;
+  (void) len;
+  (void) key;
+  (void) keysize;
+  (void) iv;
+  (void) mode;
+  return 0;
+}
+
+uint8_t
+aes_ctx_hw_init (aes_ctx_t * ctx, uint8_t * key, uint8_t keysize)
+{
+  (void) ctx;
+  (void) key;
+  (void) keysize;
+  return 0;
+}
+
+void
+aes_cbc_hw_ctx (aes_ctx_t * ctx, uint8_t * data, uint16_t len, uint8_t * iv,
+		uint8_t mode)
+{
+  (void) ctx;
+  (void) data;
+  (void) len;
+  (void) iv;
+  (void) mode;
+}
+#endif
@@ -18,40 +18,121 @@
     You should have received a copy of the GNU General Public License
     along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
-    // Emulator on linux, get random from /dev/urandom
+    Emulator on linux, get random from getrandom() (buffered pool)
+
+    For reproducible benchmark runs set environment variable OsEID_RND_SEED
+    (number), then random data are generated by a simple deterministic
+    generator (splitmix64) from this seed.  This mode is not secure!
 
 */
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/random.h>
 #include "rnd.h"
 
+#define RND_POOL_SIZE 4096
+
+static uint8_t pool[RND_POOL_SIZE];
+static uint16_t pool_pos = RND_POOL_SIZE;
+
+// -1 not initialized, 0 getrandom(), 1 deterministic (OsEID_RND_SEED)
+static int8_t deterministic = -1;
+static uint64_t seed_state;
+
 void
 rnd_init (void)
 {
+  char *env;
+
+  // card restart does not restart the deterministic sequence
+  if (deterministic >= 0)
+    return;
+
+  deterministic = 0;
+  env = getenv ("OsEID_RND_SEED");
+  if (env)
+    {
+      deterministic = 1;
+      seed_state = strtoull (env, NULL, 0);
+      fprintf (stderr, "OsEID_RND_SEED=%llu, deterministic random "
+	       "generator, not secure!\n", (unsigned long long) seed_state);
+    }
+}
+
+static uint64_t
+splitmix64 (void)
+{
+  uint64_t z = (seed_state += 0x9e3779b97f4a7c15ULL);
+
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+static void
+pool_fill (void)
+{
+  uint16_t i;
+  uint64_t v;
+  ssize_t s;
+
+  if (deterministic > 0)
+    {
+      for (i = 0; i < RND_POOL_SIZE; i += 8)
+	{
+	  v = splitmix64 ();
+	  memcpy (pool + i, &v, 8);
+	}
+    }
+  else
+    {
+      for (i = 0; i < RND_POOL_SIZE;)
+	{
+	  s = getrandom (pool + i, RND_POOL_SIZE - i, 0);
+	  if (s < 0)
+	    {
+	      if (errno != EINTR)
+		perror ("getrandom");
+	      continue;
+	    }
+	  i += s;
+	}
+    }
+  pool_pos = 0;
 }
 
+#ifdef CTR_DRBG
+void
+rnd_hw_get (uint8_t * rnd, uint8_t size)
+#else
 void
 rnd_get (uint8_t * rnd, uint8_t size)
+#endif
 {
-  FILE *f;
-  uint16_t s;
   uint16_t xsize = size;
+  uint16_t n;
 
   if (size == 0)
     xsize = 256;
 
-  for (;;)
-    {
-      f = fopen ("/dev/urandom", "r");
-      if (!f)
-	continue;
-
-      s = fread (rnd, sizeof (uint8_t), xsize, f);
+  if (deterministic < 0)
+    rnd_init ();
 
-      fclose (f);
-
-
-      if (s == xsize)
-	break;
+  while (xsize)
+    {
+      if (pool_pos == RND_POOL_SIZE)
+	pool_fill ();
+      n = RND_POOL_SIZE - pool_pos;
+      if (n > xsize)
+	n = xsize;
+      memcpy (rnd, pool + pool_pos, n);
+      // do not keep already used random data in pool
+      memset (pool + pool_pos, 0, n);
+      pool_pos += n;
+      rnd += n;
+      xsize -= n;
     }
 }